@@ -1,341 +1,2080 @@
-/*
- * Menu.cpp
- * Author : Jacques Bellavance
- * Date : September 12, 2016
- * Version : 1.00
- */
-
- /*
- This library is free software; you can redistribute it and/or
- modify it under the terms of the GNU Lesser General Public
- License as published by the Free Software Foundation; either
- version 2.1 of the License, or (at your option) any later version.
-
- This library is distributed in the hope that it will be useful,
- but WITHOUT ANY WARRANTY; without even the implied warranty of
- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
- Lesser General Public License for more details.
-
- You should have received a copy of the GNU Lesser General
- Public License along with this library; if not, write to the
- Free Software Foundation, Inc., 59 Temple Place, Suite 330,
- Boston, MA  02111-1307  USA
- */
-
-/*
- * Menu.cpp
- * Allows the use of menus in sketches.
- * The menu is declared in a String. 
- * (See menuParse() below for instructions on how a menu is built.) 
- * The menu is parsed, allowing easy navigation thru the menus.
- */
- 
-#include <Arduino.h>
-#include <Menu.h>
-
-//Constructor==================================================================================
-Menu::Menu(String items) {
-  MYitems = items;  //Full menu.
-	//Find the number of items of the menu (count the colons) and allocate memory for the nodes.
-  //Arduino's IDE reports the number of bytes used by the variables in the sketch.
-  //Add 7 bytes * (items in your menu + 1) to get the actual space used.
-	int count = 0;
-	for (int i = 0; i < MYitems.length(); i++) if (MYitems.charAt(i) == ':') count++;
-	nodes = (node*) calloc(count + 1, sizeof(node));
-
-	menuParse();          //Parse "MYitems" in "nodes[]".
-  currentNode = 1;      //Set first node as curent.
-  needsUpdate = true;   //The LCD needs to be updated.
-}//Constructor-----------------------------------------------------------------
-
- //menuParse====================================================================================================================
-//The full menu is built in the sketch in the following mannner :
-//  String menuItems = 
-//  "-READ:000"
-//  "--SENSORS:000"
-//  "---SENSOR A1:101"
-//  "---SENSOR A2:102"
-//  "--SWITCHES:000"
-//  "---SWITCH PIN 4:103"
-//  "---SWITCH PIN 5:104"
-//  "-SET:000"
-//  "--SERVO ARM:105"
-//  "--SERVO BASE:106"
-//  "-MOVE SERVOS:107";
-//The menu items contains 4 parts:
-//  a series of dashes that indicate the item's level,
-//  the label of the item,
-//  a colon (:) (token),
-//  a 3 digits number between "000" and "999" ("000" means: I have a submenu) to tag an action to be performed in the sketch.
-//In order to navigate the menu, each item is associated to a node : 
-//  struct node {       //For each item :
-//    int starts = 0;     //The index of the start of the label in MYitems,
-//    int ends = 0;       //The index of the end of the label in MYitems,
-//    int parent = 0;     //The node number of the parent of this item,
-//    int eldest = 1;     //The node number of the eldest child of this item,
-//    int action = 0;     //The action associated to this item.
-//  };
-//-----------------------------------------------------------------------------------------------------------------------------
-void Menu::menuParse() {
-  int stack[8] = { 0,0,0,0,0,0,0,0 }; //Stack (Last-in/First-out) (parent management).
-  int stackPtr = 7;                   //Stack pointer.
-  int pos = 1;                        //The position of the pointer in the string "MYitems".
-  int item = 1;                       //The pointer to the current item.
-  int curLevel = 1;                   //The level of the current item.
-  int nextLevel = 1;                  //The level of the next item.
-  int len = MYitems.length();         //The length of "MYitems".
-
-	nodes[0].eldest = 1;                                             //The first item in the menu is the eldest of nodes[0].
-  while(pos < len) {                                               //Parse the whole menu.
-    nodes[item].eldest = 1;                                          //Default value. "I have no child"
-    nodes[item].starts = pos;                                        //The start of the label.
-    while(MYitems.charAt(pos) != ':') pos++;                         //Forward to the ":" token.
-    nodes[item].ends = pos;                                          //The end of the label.
-    nodes[item].action = MYitems.substring(pos+1, pos+4).toInt();    //The integer associated to the action.
-	  nodes[item].parent = stack[stackPtr];                            //The parent of the item (current on stack).
-	  pos += 4;                                                        //Forward to the next item.
-    nextLevel = 0 ;
-    while(MYitems.charAt(pos) == '-') { pos++; nextLevel++; }        //Find the level of the next item (count dashes).
-    if (nextLevel > curLevel) {                                      //If the next item has a higher level (item is a parent) :
-		  stackPtr--; stack[stackPtr] = item;                              //Push the item as a parent on the stack.
-      nodes[item].eldest = item + 1;                                   //The next item is the eldest child of the current item.
-    }
-    if (nextLevel < curLevel) {                                      //If the next item has a lower level :
-		  for (int i = nextLevel; i < curLevel; i++) {                     //For the number of generations. 
-		    stack[stackPtr] = 0;  stackPtr++;                                //Pull as many parents as necessary off the stack. 
-      }                              
-    }
-    item++; curLevel = nextLevel;                                   //Go to next item.
-  }
-  lastNode = item-1;                                                //Set "lastNode" to the number of items in the menu.
-}//menuParse-------------------------------------------------------------------------------------------------------------------
-
-//label=====================================================================
-//Return the label of the item "node".
-//--------------------------------------------------------------------------
-String Menu::label(int node) {
-  return MYitems.substring(nodes[node].starts, nodes[node].ends);
-}//label--------------------------------------------------------------------
-
-//selectItem==========================
-//Moves the pointer to node "number".
-//------------------------------------
-void Menu::selectItem(int number) {
-	currentNode = number;
-}//-----------------------------------
-
-//parent===================================================
-//Return the number of the parent of "node".
-//---------------------------------------------------------
-int Menu::parent(int node) {
-    return nodes[node].parent;
-}//parent--------------------------------------------------
-
-//eldest============================================
-//Return the number of the eldest child of "node".
-//--------------------------------------------------
-int Menu::eldest(int node) {
-  return nodes[node].eldest;
-}//eldest-------------------------------------------
-
-//previousSibling===================================================
-//If "node" is the eldest, return "node".
-//Otherwise, return it's older sibling.
-//------------------------------------------------------------------
-int Menu::previousSibling(int node) {
-  if (eldest(parent(node)) == node) return node;
-  for (int i = node-1 ; i > 0 ; i--) {
-    if (parent(i) == parent(node)) return i;
-  }
-}//previousSibling--------------------------------------------------
-
-//nextSibling=====================================================
-//Return the next sibling of "node",
-//or "node" if it is the youngest.
-//----------------------------------------------------------------
-int Menu::nextSibling(int node) {
-  for (int i = node+1 ; i <= lastNode ; i++) {
-    if (parent(i) == parent(node)) return i;
-  }//Passed this point, no older brother has been found.
-  return node;
-}//nextSibling----------------------------------------------------
-
-//rank===========================================================
-//Returs the rank of "node" amongst it's siblings.
-//---------------------------------------------------------------
-int Menu::rank(int node) {
-	int child = eldest(parent(node)); //From the eldest child...
-	int rankOfNode = 1;
-  while (child != node) {
-    child = nextSibling(child);
-    rankOfNode++;
-  }
-  return rankOfNode;
-}//rank----------------------------------------------------------
-
-//siblingsCount========================================================================
-//returns the number of siblings of "node".
-//-------------------------------------------------------------------------------------
-int Menu::siblingsCount(int node) {
-  int parentOfNode = parent(node);
-	int child = eldest(parentOfNode); //From the eldest child...
-  int count = 0;
-  for (int i = child ; i <= lastNode; i++) if (parent(i) == parentOfNode) count++;
-  return count;
-}//siblingsCount------------------------------------------------------------------------
-
- //getCurrentItem==========================================
- //Returns the to the current node.
- //---------------------------------------------------
-int Menu::getCurrentItem() {
-	return currentNode;
-}//getCurrentItem-----------------------------------------
-
-//getAction==========================================
-//Returns the action associated to the current node.
-//---------------------------------------------------
-int Menu::getAction() {
-  return nodes[currentNode].action;
-}//getAction-----------------------------------------
-
-//getCurrentLabel========================
-//Returns the label of the current item.
-//---------------------------------------
-String Menu::getCurrentLabel() {
-  return label(currentNode);
-}//getCurrentLabel-----------------------
-
-//done================================================================================================
-//Allows the sketch to signal the library that the action is finished and that we return to the menu.
-//----------------------------------------------------------------------------------------------------
-void Menu::done() {
-	needsUpdate = true;
-}//done-----------------------------------------------------------------------------------------------
-
-//restart==================
-//Reinitialise the menu.
-//-------------------------
-void Menu::reset() {
-  currentNode = 1;
-}//restart-----------------
-
-//updated===============================
-//Signals that the LCD has been updated.
-//--------------------------------------
-void Menu::LcdUpdated() {
-  needsUpdate = false;
-}//updated------------------------------
-
-//needsUpdate========================================
-//Returns whether the LCD needs to be updated or not.
-//---------------------------------------------------
-bool Menu::LcdNeedsUpdate() {
-  return needsUpdate;
-}//needsUpdate---------------------------------------
-
-//updateLcd==================================
-//Signal that the LCD needs to be updated.
-//-------------------------------------------
-void Menu::updateLcd() {
-	needsUpdate = true;
-}//updateLcd---------------------------------
-
-//defineLcd====================================================
-//The number of columns and lines of the sketche's LCD.
-//-------------------------------------------------------------
-void Menu::defineLcd(int columns, int rows) {
-	LCDcol = columns; //Number of columns of the sketche's LCD
-	LCDrows = rows;   //Number of rows of the sketche's LCD
-}//defineLcd---------------------------------------------------
-
-//lcdLine==================================================================================================================================
-//Return a string containing the label of the item to be displayed
-//on the "requested Line" on the lcd for the current menu or submenu.
-//Preceded by a caret ">" if the item is the current item.
-//-----------------------------------------------------------------------------------------------------------------------------------------
-String Menu::lcdLine(int requestedLine) {
-	int currentRank = rank(currentNode);                              //Where the current node is amongst it's siblings.
-  if((requestedLine + 1) > siblingsCount(currentNode)) return "";   //There is no item at this rank in the menu.
-	int child = eldest(parent(currentNode));                          //From the eldest,
-	int targetRank = requestedLine + 1;                               //Case where the LCD line 0 displays the eldest.
-	if (currentRank >= LCDrows) targetRank += currentRank - LCDrows;  //If not, add the difference between the the item and LCD's line count.
-	for (int i = 1; i < targetRank; i++)  child = nextSibling(child); //Find the item at "targetRank".
-	if (currentRank == targetRank) return '>' + label(child);         //If it is the curent item, add a ">" before the label.
-	else                           return ' ' + label(child);         //If not, add a " " before the label.
-}//cdLine-----------------------------------------------------------------------------------------------------------------------------------
-
-//mapKeyChar===========================================================
-//This is used if the keypad returns characters.
-//Most matrix keypads use this scheme.
-//---------------------------------------------------------------------
-void Menu::mapKeyChar(char UP, char DOWN, char LEFT, char RIGHT) {
-	MYCHARUP = UP;
-	MYCHARDOWN = DOWN;
-	MYCHARLEFT = LEFT;
-	MYCHARRIGHT = RIGHT;
-}//mapKeyChars---------------------------------------------------------
-
- //mapKeyint-===========================================================
- //This is used if the keypad returns integers.
- //---------------------------------------------------------------------
-void Menu::mapKeyInt(int UP, int DOWN, int LEFT, int RIGHT) {
-	MYUP = UP;
-	MYDOWN = DOWN;
-	MYLEFT = LEFT;
-	MYRIGHT = RIGHT;
-}//mapKeyInt---------------------------------------------------------
-
-//updateMenu=============================================================================
-//Sets as current, the new item according to the key pressed.
-//Returns the action associated to the item.
-//UP, DOWN and LEFT sets the current node to, respectively:
-//the previous sibling, the next sibling and the parent of the current node.
-//For the RIGHT key, there are two possibilities :
-//- The action associated to the node needs to be carried out by the sketch. (>"000")
-//- The action is "000" and the current node becomes it's eldest child
-//Raise the "needsUpdate" flag if the node changed.
-//---------------------------------------------------------------------------------------
-int Menu::updateMenu(int key) {
-  int node = currentNode;
-	if (key == UP) currentNode = previousSibling(currentNode);
-	if (key == DOWN) currentNode = nextSibling(currentNode);
-	if (key == LEFT && (parent(currentNode) != 0)) currentNode = parent(currentNode);
-	if (key == RIGHT) {
-    int action = getAction();
-		if (action > 0) return action;
-		else            if (eldest(currentNode) != 1) currentNode = eldest(currentNode);
-	}
-  if (currentNode != node) needsUpdate = true;
-	return 0;
-}//updateMenu-----------------------------------------------------------------------------
-
-//update===========================================
-//The Sketche's keypad returns integers.
-//See Menu::mapKeyInt().
-//See Menu::updateMenu() for more details.
-//-------------------------------------------------
-int Menu::update(int key) {
-	if (key == 0) return 0;
-	int action = 0;
-	if (key == MYUP)  action = updateMenu(UP);
-	if (key == MYDOWN)  action = updateMenu(DOWN);
-	if (key == MYLEFT)  action = updateMenu(LEFT);
-	if (key == MYRIGHT)  action = updateMenu(RIGHT);
-	return action;
-}//update------------------------------------------
-
-//update===========================================
-//The Sketche's keypad returns chars.
-// See Menu::mapKeyChar().
-//See Menu::updateMenu() for more details.
-//-------------------------------------------------
-int Menu::update(char key) {
-  if (key == char(0)) return 0;
-  int action = 0;
-	if (key == MYCHARUP)  action = updateMenu(UP);
-	if (key == MYCHARDOWN)  action = updateMenu(DOWN);
-	if (key == MYCHARLEFT)  action = updateMenu(LEFT);
-	if (key == MYCHARRIGHT)  action = updateMenu(RIGHT);
-  return action;
-}//update------------------------------------------
-
+/*
+ * Menu.cpp
+ * Author : Jacques Bellavance
+ * Date : September 12, 2016
+ * Version : 1.00
+ */
+
+ /*
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General
+ Public License along with this library; if not, write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Menu.cpp
+ * Allows the use of menus in sketches.
+ * The menu is declared in a String. 
+ * (See menuParse() below for instructions on how a menu is built.) 
+ * The menu is parsed, allowing easy navigation thru the menus.
+ */
+ 
+#include <Menu.h>
+
+//Statistics (see MENU_STATS in Menu.h)==========================================
+//MENU_STAT(x) compiles "x" only when the statistics are wanted : zero cost otherwise.
+//--------------------------------------------------------------------------------
+#if defined(MENU_STATS)
+#define MENU_STAT(x) x
+#if defined(ARDUINO)
+static unsigned long menuMicros() { return micros(); }
+static unsigned long menuMillis() { return millis(); }
+#else
+#include <time.h>
+static unsigned long menuMicros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+static unsigned long menuMillis() { return menuMicros() / 1000; }
+#endif
+
+//MenuStopwatch===================================================
+//Times the block it is declared in, into "timing".
+//----------------------------------------------------------------
+struct MenuStopwatch {
+  MenuTiming &timing;
+  unsigned long started;
+  MenuStopwatch(MenuTiming &t) : timing(t), started(menuMicros()) {}
+  ~MenuStopwatch() {
+    unsigned long elapsed = menuMicros() - started;
+    if (timing.count == 0 || elapsed < timing.min) timing.min = elapsed;
+    if (elapsed > timing.max) timing.max = elapsed;
+    timing.total += elapsed;
+    timing.count++;
+  }
+};//MenuStopwatch-------------------------------------------------
+#else
+#define MENU_STAT(x)
+#endif
+
+//menuGrow=========================================================================
+//The new size of a table of "size" entries of "width" bytes, that must hold "needed" :
+//twice as many, or "needed" if it's more, but no more than "most" (nor than a size_t can count).
+//Less than "needed" : the table can not grow that much.
+//---------------------------------------------------------------------------------
+static long menuGrow(long size, long needed, long most, size_t width) {
+  if ((unsigned long) most > (size_t) -1 / width) most = (long) ((size_t) -1 / width);
+  long grown = size > most / 2 ? most : 2 * size;                //(Doubled without overflow.)
+  if (grown < needed) grown = needed < most ? needed : most;
+  return grown;
+}//menuGrow-------------------------------------------------------------------------
+
+#if defined(ARDUINO)
+//Constructor==================================================================================
+//The menu is copied (in "ownText").
+//Without the memory for the copy, a one item menu says so (error() : NO_MEMORY).
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(String items) {
+  ownText = (char*) malloc(items.length() + 1);   //Full menu.
+  if (!ownText) {
+    treeInit("-NO MEMORY:000", false);
+    menuError(MenuTable::NO_MEMORY, 0, 0, 0);
+    return;
+  }
+  strcpy(ownText, items.c_str());
+  treeInit(ownText, false);                       //Read it from the copy.
+}//Constructor-----------------------------------------------------------------
+
+//Constructor==================================================================================
+//The menu stays in flash (PROGMEM) and is read from there. Only "nodes[]" uses RAM.
+//  const char menuItems[] PROGMEM = "-READ:000" ... ;
+//  Menu menu((const __FlashStringHelper *) menuItems);
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(const __FlashStringHelper *items) {
+  treeInit((const char *) items, true);
+}//Constructor-----------------------------------------------------------------
+#endif
+
+//Constructor==================================================================================
+//The menu stays where it is (in RAM, or in a memory-mapped file) and is read from there.
+//It must live as long as the Menu.
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(const char *items) {
+  treeInit(items, false);
+}//Constructor-----------------------------------------------------------------
+
+//Constructor==================================================================================
+//Same, for the first "length" chars at "items" : nothing past them is read, there may be no '\0'
+//(a menu file read in a buffer, or mmap()'ed).
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(const char *items, long length) {
+  treeInit(items, false, length < 0 ? 0 : length);
+}//Constructor-----------------------------------------------------------------
+
+//Constructor==================================================================================
+//A precompiled menu (see MenuImage and extras/menuc), used where it is : nothing is parsed.
+//"size" : the bytes at "image" (e.g. sizeof() the array, or the bytes read from the SD card).
+//The image must live as long as the MenuTree.
+//On AVR, an image in PROGMEM (inFlash) has it's nodes copied in RAM, the labels stay in flash.
+//A damaged image gives a one item menu that says so (error() : BAD_IMAGE, or NO_MEMORY).
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(const MenuImage *image, long size, bool inFlash) {
+  if (imageCheck(image, size, inFlash) == 0) {
+    treeInit("-BAD MENU IMAGE:000", false);
+    parseError.code = MenuTable::BAD_IMAGE;
+    return;
+  }
+  MenuImage header;
+  imageRead(&header, image, 0, sizeof(header), inFlash);
+  long nodesAt = sizeof(MenuImage);                                   //Where the parts are.
+  long sortedAt = nodesAt + (header.nodes + 1) * sizeof(MenuNode);
+  long textAt = sortedAt + header.labels * sizeof(menuIndex);
+  const byte *at = (const byte *) image;
+  const MenuNode *table = (const MenuNode *) (at + nodesAt);
+  const menuIndex *sorted = (const menuIndex *) (at + sortedAt);
+  if (inFlash) {                                                      //The nodes are read all the time :
+    ownNodes = (node*) malloc(sortedAt - nodesAt);                    //in RAM.
+    if (ownNodes) ownLabels = (menuIndex*) malloc(textAt > sortedAt ? textAt - sortedAt : 1);
+    if (!ownNodes || !ownLabels) {
+      treeInit("-NO MEMORY:000", false);
+      menuError(MenuTable::NO_MEMORY, 0, 0, 0);
+      return;
+    }
+    imageRead(ownNodes, image, nodesAt, sortedAt - nodesAt, inFlash);
+    imageRead(ownLabels, image, sortedAt, textAt - sortedAt, inFlash);
+    table = ownNodes;
+    sorted = ownLabels;
+    nodeCapacity = header.nodes + 1;
+    labelCapacity = header.labels;
+  }
+  labelCount = header.labels;                                         //(Already sorted.)
+  treeInit((const char *) (at + textAt), header.length, table, header.nodes, inFlash, sorted);
+}//Constructor-----------------------------------------------------------------
+
+//Constructors=================================================================================
+//A Menu with a tree of it's own (see the MenuTree constructors above), on the heap :
+//a Menu sharing a tree holds only a pointer.
+//---------------------------------------------------------------------------------------------
+#if defined(ARDUINO)
+Menu::Menu(String items) : ownTree(new MenuTree(items)) { menuInit(ownTree); }
+Menu::Menu(const __FlashStringHelper *items) : ownTree(new MenuTree(items)) { menuInit(ownTree); }
+#endif
+Menu::Menu(const char *items) : ownTree(new MenuTree(items)) { menuInit(ownTree); }
+Menu::Menu(const char *items, long length) : ownTree(new MenuTree(items, length)) { menuInit(ownTree); }
+Menu::Menu(const MenuImage *image, long size, bool inFlash) : ownTree(new MenuTree(image, size, inFlash)) { menuInit(ownTree); }
+Menu::Menu(MenuTree &&tree) : ownTree(new MenuTree(static_cast<MenuTree &&>(tree))) { menuInit(ownTree); }
+//Constructors---------------------------------------------------------------------------------
+
+//Constructor==================================================================================
+//A Menu that shares "tree" with other Menus : nothing is parsed, nothing is copied.
+//The tree must live as long as the Menu.
+//  MenuTree tree(menuItems);
+//  Menu console1(tree), console2(tree);
+//---------------------------------------------------------------------------------------------
+Menu::Menu(const MenuTree &tree) {
+  menuInit(tree);
+}//Constructor-----------------------------------------------------------------
+
+//menuInit=====================================================================================
+//Same, for "ownTree". Without the memory for it (new returns 0 on AVR), the Menu
+//shows a one item menu that says so (error() : NO_MEMORY).
+//---------------------------------------------------------------------------------------------
+void Menu::menuInit(const MenuTree *tree) {
+  menuInit(tree ? *tree : MenuTree::noMemory());
+}//menuInit------------------------------------------------------------------------------------
+
+//noMemory=====================================================================================
+//A one item menu, "NO MEMORY", that takes nothing from the heap. It's built by the initializer
+//of the static : once, even when several threads get there first (C++11).
+//---------------------------------------------------------------------------------------------
+MenuTree::MenuTree(MenuNode *table) {
+  static const char text[] = "-NO MEMORY:000";
+  static const menuIndex sorted[1] = {1};
+  table[1].start = 1;
+  table[1].length = 9;
+  table[1].previous = table[1].next = 1;
+  table[0].children = 1;
+  labelCount = 1;
+  treeInit(text, sizeof(text) - 1, table, 1, false, sorted);
+  parseError.code = MenuTable::NO_MEMORY;
+}
+
+const MenuTree &MenuTree::noMemory() {
+  static MenuNode nodes[2];
+  static const MenuTree tree(nodes);
+  return tree;
+}//noMemory------------------------------------------------------------------------------------
+
+//menuInit=====================================================================================
+//Common part of the constructors : the Menu starts at the top of "tree".
+//---------------------------------------------------------------------------------------------
+void Menu::menuInit(const MenuTree &tree) {
+  sharedTree = (&tree != ownTree);
+  menuSync(tree);
+  currentNode = nodes[0].eldest;  //Set first node as curent.
+  defineLcd(LCDcol, LCDrows);  //Default LCD.
+  needsUpdate = true;   //The LCD needs to be updated.
+  MENU_STAT(resetStats(); statistics.parseTime = tree.parseTime);
+}//menuInit------------------------------------------------------------------------------------
+
+//menuInit=====================================================================================
+//Same, for a MENU_TABLE : the Menu reads the table where it is, nothing is taken from the heap.
+//It gets a tree of it's own only when it is changed (see treeEditable()).
+//---------------------------------------------------------------------------------------------
+void Menu::menuInit(const char *text, int length, const MenuNode *table, int last, const menuIndex *sorted) {
+  sharedTree = false;
+  MYtext = text;
+  MYflash = false;
+  MYlength = length;
+  MYextra = 0;
+  MYextraLength = 0;
+  nodes = table;
+  byLabel = sorted;
+  labelCount = last;
+  lastNode = last;
+  treeError = MenuError();
+  currentNode = nodes[0].eldest;
+  defineLcd(LCDcol, LCDrows);
+  needsUpdate = true;
+  MENU_STAT(resetStats());
+}//menuInit------------------------------------------------------------------------------------
+
+//treeEditable=================================================================================
+//Before a change : a Menu made from a MENU_TABLE gets a tree of it's own (on the heap), that
+//reads the same table. Then see MenuTree::editable(). Returns false if there is no memory for it.
+//---------------------------------------------------------------------------------------------
+bool Menu::treeEditable() {
+  if (!ownTree) {
+    MenuTree *tree = new MenuTree();
+    if (!tree) return false;
+    tree->labelCount = labelCount;
+    tree->treeInit(MYtext, MYlength, nodes, lastNode, MYflash, byLabel);
+    ownTree = MenuObject<MenuTree>(tree);
+  }
+  return ownTree->editable();
+}//treeEditable--------------------------------------------------------------------------------
+
+//menuSync=====================================================================================
+//Copies the pointers of "tree" : the Menu only reads the tree thru them.
+//Again after each change, as the tables may have moved.
+//---------------------------------------------------------------------------------------------
+void Menu::menuSync(const MenuTree &tree) {
+  MYtext = tree.MYtext;       //Where the menu is.
+  MYflash = tree.MYflash;
+  MYlength = tree.MYlength;
+  MYextra = tree.ownExtra;
+  MYextraLength = tree.extraLength;
+  nodes = tree.nodes;
+  byLabel = tree.byLabel;
+  labelCount = tree.labelCount;
+  lastNode = tree.lastNode;
+  treeError = tree.parseError;
+}//menuSync------------------------------------------------------------------------------------
+
+//treeInit=====================================================================================
+//Common part of the constructors.
+//"length" : the chars of the menu (-1 : up to the '\0'). Nothing past them is read.
+//A menu without a single good item gives a one item menu that says so (see error()),
+//and so does a menu longer than the offsets of the labels can go (LONG_MENU, see MENU_MAX_LENGTH).
+//---------------------------------------------------------------------------------------------
+void MenuTree::treeInit(const char *text, bool inFlash, long length) {
+  MENU_STAT(unsigned long started = menuMicros());
+  MYtext = text;                                               //Where the menu is,
+  MYflash = inFlash;                                           //in RAM or in flash.
+#if defined(ARDUINO)
+  if (length < 0) length = inFlash ? strlen_P(text) : strlen(text);  //The length of the menu.
+#else
+  if (length < 0) length = strlen(text);                       //The length of the menu.
+#endif
+  MYlength = length > MENU_MAX_LENGTH ? 0 : length;            //(Too long : nothing is read.)
+  //Arduino's IDE reports the number of bytes used by the variables in the sketch.
+  //Add sizeof(MenuNode) bytes (12 on AVR) * (items in your menu + 1) to get the actual space used.
+	menuParse();          //Parse the menu in "ownNodes[]".
+  if (length > MENU_MAX_LENGTH) menuError(MenuTable::LONG_MENU, 1, 1, MENU_MAX_LENGTH);
+  if (lastNode == 0) {                                         //Nothing to show :
+    MenuError error = parseError;
+    MYtext = "-BAD MENU:000";                                  //say so.
+    MYflash = false;
+    MYlength = strlen(MYtext);
+    menuParse();
+    parseError = error;
+  }
+  nodes = ownNodes;
+  labelIndex();         //Sort the labels for itemNumber() and typeAhead().
+  MENU_STAT(parseTime = menuMicros() - started);
+}//treeInit------------------------------------------------------------------------------------
+
+//treeInit=====================================================================================
+//Common part of the constructors, for a menu that was already parsed (see MENU_TABLE and MenuImage in Menu.h).
+//The table is used where it is: nothing is parsed, nothing is allocated.
+//The labels are sorted, unless "sorted" already holds them ("labelCount" entries).
+//---------------------------------------------------------------------------------------------
+void MenuTree::treeInit(const char *text, int length, const MenuNode *table, int last, bool inFlash, const menuIndex *sorted) {
+  MENU_STAT(unsigned long started = menuMicros());
+  MYtext = text;
+  MYflash = inFlash;
+  MYlength = length;
+  nodes = table;
+  lastNode = last;
+  if (sorted) byLabel = sorted;
+  else labelIndex();    //Sort the labels for itemNumber() and typeAhead().
+  MENU_STAT(parseTime = menuMicros() - started);
+}//treeInit------------------------------------------------------------------------------------
+
+//imageRead===================================================================
+//Copies "size" bytes of "image", from "pos", to "to" (the image in RAM or in flash).
+//----------------------------------------------------------------------------
+void MenuTree::imageRead(void *to, const MenuImage *image, long pos, long size, bool inFlash) {
+  const byte *from = (const byte *) image + pos;
+#if defined(ARDUINO)
+  if (inFlash) {
+    for (long i = 0; i < size; i++) ((byte *) to)[i] = pgm_read_byte(from + i);
+    return;
+  }
+#else
+  (void) inFlash;
+#endif
+  memcpy(to, from, size);
+}//imageRead------------------------------------------------------------------
+
+//imageSum====================================================================
+//The Fletcher-16 checksum of the bytes of "image", from "pos" to "end".
+//The sums are reduced every 256 bytes only (no division per byte on AVR).
+//----------------------------------------------------------------------------
+uint16_t MenuTree::imageSum(const MenuImage *image, long pos, long end, bool inFlash) {
+  uint32_t sum1 = 0, sum2 = 0;
+  byte block[32];
+  int summed = 0;                                      //Bytes since the last reduction.
+  while (pos < end) {
+    int size = (end - pos < (long) sizeof(block)) ? end - pos : sizeof(block);
+    imageRead(block, image, pos, size, inFlash);
+    for (int i = 0; i < size; i++) { sum1 += block[i]; sum2 += sum1; }
+    pos += size;
+    summed += size;
+    if (summed >= 256 || pos == end) { sum1 %= 255; sum2 %= 255; summed = 0; }
+  }
+  return (sum2 << 8) | sum1;
+}//imageSum-------------------------------------------------------------------
+
+//imageSize===================================================================
+//The size of the image described by "header".
+//----------------------------------------------------------------------------
+long MenuTree::imageSize(const MenuImage &header) {
+  return sizeof(MenuImage) + (header.nodes + 1) * sizeof(MenuNode) + header.labels * sizeof(menuIndex) + header.length + 1;
+}//imageSize------------------------------------------------------------------
+
+//imageCheck==================================================================================
+//Returns the size of "image" (header included) if it is a valid image for this build
+//(alignment, version, MENU_INDEX_BITS, byte order, size, checksum, nodes), 0 if not.
+//"size" : the number of bytes available at "image". Nothing past them is read.
+//--------------------------------------------------------------------------------------------
+long MenuTree::imageCheck(const MenuImage *image, long size, bool inFlash) {
+  if (!image || size < (long) sizeof(MenuImage)) return 0;
+  if (!inFlash && ((uintptr_t) image & 3) != 0) return 0;                                      //(Used where it is : aligned on 4 bytes.)
+  MenuImage header;
+  imageRead(&header, image, 0, sizeof(header), inFlash);
+  if (memcmp(header.magic, "MENU", 4) != 0 || header.version != MENU_IMAGE_VERSION) return 0;   //Not an image.
+  if (header.indexBits != MENU_INDEX_BITS || header.nodeSize != sizeof(MenuNode)) return 0;    //Made for an other build.
+  if (header.order != 0x0102) return 0;                                                         //Or an other processor.
+  if (header.nodes < 1 || header.nodes > (uint32_t) MENU_MAX_ITEMS || header.labels > header.nodes) return 0;
+  if (header.length > (uint32_t) MENU_MAX_LENGTH) return 0;                                    //More than the offsets can hold.
+  long left = size - sizeof(MenuImage);                                                         //Truncated?
+  if (header.nodes >= (unsigned long) left / sizeof(MenuNode)) return 0;                        //(One part at a time,
+  left -= (header.nodes + 1) * sizeof(MenuNode);                                                //so that nothing overflows.)
+  if (header.labels > (unsigned long) left / sizeof(menuIndex)) return 0;
+  left -= header.labels * sizeof(menuIndex);
+  if (header.length >= (unsigned long) left) return 0;
+  long total = imageSize(header);
+  if (imageSum(image, sizeof(MenuImage), total, inFlash) != header.checksum) return 0;          //Damaged.
+  if (!imageNodes(image, header, inFlash)) return 0;                                            //Or made up.
+  return total;
+}//imageCheck---------------------------------------------------------------------------------
+
+//imageNode==================================================================
+//Node "item" of the image.
+//----------------------------------------------------------------------------
+MenuNode MenuTree::imageNode(const MenuImage *image, uint32_t item, bool inFlash) {
+  MenuNode n;
+  imageRead(&n, image, sizeof(MenuImage) + item * sizeof(MenuNode), sizeof(n), inFlash);
+  return n;
+}//imageNode-------------------------------------------------------------------
+
+//imageNodes=================================================================================
+//Are the nodes of the image a menu that can be walked? (Checked before the nodes are used.)
+//  the labels within the menu, the links and the sorted labels within the nodes,
+//  the nodes in the order of the menu (as they are parsed) : a parent before it's children,
+//  the eldest child and the next sibling after the node, so that no walk can go round in circles,
+//  the children of each node linked as their ranks and their count say (none left out, none twice),
+//  no removed node, and one sorted label per node.
+//-------------------------------------------------------------------------------------------
+bool MenuTree::imageNodes(const MenuImage *image, const MenuImage &header, bool inFlash) {
+  if (header.labels != header.nodes) return false;
+  uint32_t shown = 0, linked = 0;                                    //The items not hidden, the children linked.
+  for (uint32_t i = 0; i <= header.nodes; i++) {
+    MenuNode n = imageNode(image, i, inFlash);
+    if (n.start > header.length || n.length > header.length - n.start) return false;
+    if (n.parent > header.nodes || n.eldest > header.nodes || n.previous > header.nodes || n.next > header.nodes) return false;
+    if (n.rank > header.nodes || n.children > header.nodes || (n.flags & MENU_REMOVED)) return false;
+    if (i > 0 && (n.parent >= i || n.next < i || n.rank < 1)) return false;      //(Forward only.)
+    if (i > 0 && !(n.flags & MENU_HIDDEN)) shown++;
+    if (n.children == 0) continue;
+    if (n.eldest <= i) return false;
+    uint32_t at = n.eldest, youngest = 0;                              //The children, eldest first.
+    for (uint32_t rank = 1; rank <= n.children; rank++) {
+      MenuNode child = imageNode(image, at, inFlash);
+      if (child.parent != i || child.rank != rank || (child.flags & MENU_HIDDEN) || child.next > header.nodes) return false;
+      if ((rank == n.children) != (child.next == at)) return false;     //(Only the youngest is it's own next.)
+      if (rank < n.children && imageNode(image, child.next, inFlash).previous != at) return false;
+      youngest = at;
+      at = child.next;
+    }
+    if (imageNode(image, n.eldest, inFlash).previous != youngest) return false;  //(The eldest knows the youngest.)
+    linked += n.children;
+  }
+  if (linked != shown) return false;
+  long at = sizeof(MenuImage) + (header.nodes + 1) * sizeof(MenuNode);
+  for (uint32_t i = 0; i < header.labels; i++, at += sizeof(menuIndex)) {
+    menuIndex item;
+    imageRead(&item, image, at, sizeof(item), inFlash);
+    if (item < 1 || item > header.nodes) return false;
+  }
+  return true;
+}//imageNodes--------------------------------------------------------------------------------
+
+//image=======================================================================================
+//Writes the image of the menu (see MenuImage) in "buffer" (aligned on 4 bytes).
+//Returns it's size. Nothing is written if "size" is too small : call it with 0 to get the size.
+//--------------------------------------------------------------------------------------------
+long MenuTree::image(void *buffer, long size) const {
+  MenuImage header = {{'M', 'E', 'N', 'U'}, MENU_IMAGE_VERSION, MENU_INDEX_BITS, sizeof(MenuNode), 0,
+                      0x0102, 0, (uint32_t) lastNode, (uint32_t) labelCount, (uint32_t) (MYlength + extraLength)};
+  long total = imageSize(header);
+  if (!buffer || size < total) return total;
+  byte *at = (byte *) buffer + sizeof(MenuImage);
+  memcpy(at, nodes, (lastNode + 1) * sizeof(MenuNode));             //The nodes,
+  at += (lastNode + 1) * sizeof(MenuNode);
+  memcpy(at, byLabel, labelCount * sizeof(menuIndex));              //the node numbers sorted by label,
+  at += labelCount * sizeof(menuIndex);
+  for (int i = 0; i < MYlength + extraLength; i++) at[i] = itemChar(i);  //and the menu (with the labels added).
+  at[MYlength + extraLength] = '\0';
+  memcpy(buffer, &header, sizeof(MenuImage));
+  header.checksum = imageSum((const MenuImage *) buffer, sizeof(MenuImage), total, false);
+  memcpy(buffer, &header, sizeof(MenuImage));
+  return total;
+}//image---------------------------------------------------------------------------------------
+
+//itemChar==============================================================
+//Return the character at "pos" in the menu, wherever the menu is.
+//Past the end of the menu, the labels added or changed (see renameItem()), then '\0'.
+//----------------------------------------------------------------------
+char Menu::itemChar(int pos) {
+  if (pos >= MYlength) return (pos - MYlength < MYextraLength) ? MYextra[pos - MYlength] : '\0';
+#if defined(ARDUINO)
+  if (MYflash) return pgm_read_byte(MYtext + pos);
+#endif
+  return MYtext[pos];
+}//itemChar-------------------------------------------------------------
+
+//itemChar==============================================================
+//Same, for the tree being built.
+//----------------------------------------------------------------------
+char MenuTree::itemChar(int pos) const {
+  if (pos >= MYlength) return (pos - MYlength < extraLength) ? ownExtra[pos - MYlength] : '\0';
+#if defined(ARDUINO)
+  if (MYflash) return pgm_read_byte(MYtext + pos);
+#endif
+  return MYtext[pos];
+}//itemChar-------------------------------------------------------------
+
+ //menuParse====================================================================================================================
+//The full menu is built in the sketch in the following mannner :
+//  String menuItems = 
+//  "-READ:000"
+//  "--SENSORS:000"
+//  "---SENSOR A1:101"
+//  "---SENSOR A2:102"
+//  "--SWITCHES:000"
+//  "---SWITCH PIN 4:103"
+//  "---SWITCH PIN 5:104"
+//  "-SET:000"
+//  "--SERVO ARM:105"
+//  "--SERVO BASE:106"
+//  "-MOVE SERVOS:107";
+//The menu items contains 4 parts:
+//  a series of dashes that indicate the item's level,
+//  the label of the item,
+//  a colon (:) (token),
+//  a 3 digits number between "000" and "999" ("000" means: I have a submenu) to tag an action to be performed in the sketch.
+//In order to navigate the menu, each item is associated to a node : 
+//  struct node {       //For each item :
+//    int start = 0;      //The index of the start of the label in the menu,
+//    int length = 0;     //The length of the label (up to 255 chars),
+//    int parent = 0;     //The node number of the parent of this item,
+//    int eldest = 1;     //The node number of the eldest child of this item,
+//    int previous = 0;   //The node number of the previous sibling (the youngest if it is the eldest),
+//    int next = 0;       //The node number of the next sibling (itself if it is the youngest),
+//    int rank = 1;       //The rank of this item amongst it's siblings,
+//    int children = 0;   //The number of children of this item,
+//    int action = 0;     //The action associated to this item.
+//  };
+//The sibling links, the ranks and the children counts are set here once,
+//so that moving around the menu and filling the LCD never have to scan "nodes[]".
+//The parents are found by climbing up the nodes already parsed : there is no limit to the depth of the menu.
+//There is a limit to the number of items : MENU_MAX_ITEMS (see MENU_INDEX_BITS in Menu.h).
+//A menu read from a file may have one item per line : the line ends between the items are skipped.
+//The menu is read once : "ownNodes[]" grows as the items are found (twice as many nodes at a time),
+//and is cut down to the items found at the end.
+//The parsing stops at the first error (see MenuError in Menu.h) : the items before it are kept.
+//-----------------------------------------------------------------------------------------------------------------------------
+void MenuTree::menuParse() {
+  int parentNode = 0;                 //The parent of the current item.
+  int older = 0;                      //The older sibling of the current item (0 : it is the eldest).
+  int pos = 0;                        //The position of the pointer in the menu.
+  int item = 1;                       //The pointer to the current item.
+  int curLevel = 0;                   //The level of the item before (0 : the root).
+  int len = MYlength;                 //The length of the menu.
+  long line = 1;                      //The line of the pointer (for the errors).
+  long capacity = menuGrow(0, len / 16 + 2, MENU_MAX_ITEMS + 1, sizeof(node));  //The nodes allocated (a first guess : an item takes 16 chars).
+
+  parseError = MenuError();
+  ownNodes = MenuMemory<node>();
+  ownNodes = (node*) malloc(capacity * sizeof(node));
+  if (!ownNodes) capacity = 0;
+  else ownNodes[0] = node();                                       //The root. It's eldest is the first item in the menu.
+  while (pos < len && (itemChar(pos) == '\r' || itemChar(pos) == '\n')) if (itemChar(pos++) == '\n') line++;  //(Blank lines.)
+  if (pos == len) menuError(MenuTable::NO_ITEMS, item, line, pos);
+  else if (itemChar(pos) != '-') menuError(MenuTable::NO_DASH, item, line, pos);
+  while (pos < len && parseError.code == MenuTable::NONE) {        //Parse the whole menu.
+    int first = pos;                                                 //The start of the item.
+    int level = 0;
+    while (pos < len && itemChar(pos) == '-') { pos++; level++; }    //The level of the item (count dashes).
+    if (level > curLevel + 1) { menuError(MenuTable::LEVEL_JUMP, item, line, first); break; }  //(One generation at a time.)
+    int colon = itemFind(pos, len, ':');                             //Forward to the ":" token,
+    if (colon == len || itemFind(pos, colon, '\n') != colon) { menuError(MenuTable::MISSING_COLON, item, line, first); break; }  //(on the same line).
+    if (colon - pos > 255) { menuError(MenuTable::LONG_LABEL, item, line, pos + 255); break; }  //(The length of a label is a byte.)
+    int action = 0;                                                  //The integer associated to the action :
+    for (int i = colon + 1; i < colon + 4; i++) {                    //exactly 3 digits,
+      if (i >= len || !isdigit(itemChar(i))) { menuError(MenuTable::BAD_ACTION, item, line, i); break; }
+      action = action * 10 + (itemChar(i) - '0');
+    }
+    char after = colon + 4 < len ? itemChar(colon + 4) : '-';        //then the next item (or a line end).
+    if (parseError.code == MenuTable::NONE && after != '-' && after != '\r' && after != '\n') menuError(MenuTable::BAD_ACTION, item, line, colon + 4);
+    if (parseError.code != MenuTable::NONE) break;
+    if (item > MENU_MAX_ITEMS) { menuError(MenuTable::TOO_MANY_ITEMS, item, line, first); break; }  //(as many as the node numbers can hold)
+    if (item >= capacity) {                                          //One more node :
+      long more = menuGrow(capacity, item + 1, MENU_MAX_ITEMS + 1, sizeof(node));  //twice as many.
+      node *table = more > item ? (node*) realloc(ownNodes, more * sizeof(node)) : 0;
+      if (!table) { menuError(MenuTable::NO_MEMORY, item, line, first); break; }
+      if (capacity == 0) table[0] = node();
+      ownNodes = table;
+      capacity = more;
+    }
+    node *nodes = ownNodes;
+    if (level > curLevel && item > 1) {                              //If the item is one level deeper (the item before is a parent) :
+      nodes[item - 1].eldest = item;                                   //It is the eldest child of the item before.
+      parentNode = item - 1;                                           //It's parent is the item before,
+      older = 0;                                                       //and it starts a new list of siblings.
+    }
+    else if (item > 1) {                                             //If not :
+      older = item - 1;                                                //It is a sibling of the item before,
+      for ( ; curLevel > level && parentNode != 0; curLevel--) {       //or of one of it's ancestors.
+        older = parentNode;                                              //Climb up the parents (no stack needed, no depth limit).
+        parentNode = nodes[parentNode].parent;
+      }
+    }
+    nodes[item] = node();                                            //Default values : "I have no child", "I am the youngest".
+    nodes[item].start = pos;                                         //The start of the label.
+    nodes[item].length = colon - pos;                                //The length of the label.
+    nodes[item].action = action;
+	  nodes[item].parent = parentNode;                                 //The parent of the item.
+    nodes[item].next = item;
+    if (older == 0) nodes[item].previous = item;                     //If the item is the eldest, it is it's own previous sibling.
+    else {                                                           //If not :
+      nodes[item].previous = older;                                    //Link it to it's older sibling,
+      nodes[older].next = item;                                        //and the older sibling to it.
+      nodes[item].rank = nodes[older].rank + 1;                        //It comes right after it's older sibling.
+      nodes[nodes[parentNode].eldest].previous = item;                 //The eldest knows the youngest (for END).
+    }
+    nodes[parentNode].children++;                                    //One more child for the parent.
+    pos = colon + 4;                                                 //Forward to the next item,
+    while (pos < len && (itemChar(pos) == '\r' || itemChar(pos) == '\n')) if (itemChar(pos++) == '\n') line++;  //on this line or the next.
+    item++; curLevel = level;                                        //Go to next item.
+  }
+  lastNode = item - 1;                                              //Set "lastNode" to the number of items in the menu.
+  if (lastNode + 1 < capacity) {                                    //Give back the nodes not used.
+    node *table = (node*) realloc(ownNodes, (lastNode + 1) * sizeof(node));
+    if (table) { ownNodes = table; capacity = lastNode + 1; }
+  }
+  nodeCapacity = capacity;
+}//menuParse-------------------------------------------------------------------------------------------------------------------
+
+//itemFind=================================================================================
+//Returns the position of the first "c" in the menu, from "pos" to "end" ("end" if there is none).
+//A menu in RAM is searched by memchr() (many characters at a time), a menu in flash one by one.
+//-----------------------------------------------------------------------------------------
+int MenuTree::itemFind(int pos, int end, char c) const {
+#if defined(ARDUINO)
+  if (MYflash) {
+    while (pos < end && pgm_read_byte(MYtext + pos) != c) pos++;
+    return pos;
+  }
+#endif
+  if (pos >= end) return end;
+  const char *found = (const char *) memchr(MYtext + pos, c, end - pos);
+  return found ? found - MYtext : end;
+}//itemFind--------------------------------------------------------------------------------
+
+//menuError===========================================================
+//Records what is wrong with the menu (see MenuError), and where.
+//--------------------------------------------------------------------
+void MenuTree::menuError(int code, int item, long line, int pos) {
+  parseError.code = code;
+  parseError.item = item;
+  parseError.line = line;
+  parseError.offset = pos;
+}//menuError----------------------------------------------------------
+
+#if defined(ARDUINO)
+//label=====================================================================
+//Return the label of "item" (a node, or an entry of a list, see lineItem()).
+//--------------------------------------------------------------------------
+String Menu::label(long item) {
+  MENU_STAT(statistics.strings++);
+  String text;                                                   //Wherever the label is, one char at a time.
+  int length = itemLength(item);
+  text.reserve(length);
+  for (int i = 0; i < length; i++) text += itemLabel(item, i);
+  return text;
+}//label--------------------------------------------------------------------
+#endif
+
+//labelIndex=====================================================================================
+//Sorts the node numbers by label in "ownLabels[]" (ignoring case, equal labels by node number),
+//so that itemNumber() and typeAhead() use a binary search instead of comparing every label.
+//A heap sort : no recursion, no extra memory.
+//Without the memory for it, nothing is found by label (error() says NO_MEMORY).
+//-----------------------------------------------------------------------------------------------
+void MenuTree::labelIndex() {
+  ownLabels = (menuIndex*) calloc(lastNode > 0 ? lastNode : 1, sizeof(menuIndex));
+  if (!ownLabels) {
+    byLabel = 0;
+    labelCount = labelCapacity = 0;
+    if (parseError.code == MenuTable::NONE) menuError(MenuTable::NO_MEMORY, 0, 0, 0);
+    return;
+  }
+  for (int i = 0; i < lastNode; i++) ownLabels[i] = i + 1;
+  for (int i = lastNode / 2 - 1; i >= 0; i--) labelSift(i, lastNode);  //Build the heap,
+  for (int end = lastNode - 1; end > 0; end--) {                      //then take the largest out, one by one.
+    menuIndex largest = ownLabels[0]; ownLabels[0] = ownLabels[end]; ownLabels[end] = largest;
+    labelSift(0, end);
+  }
+  byLabel = ownLabels;
+  labelCount = lastNode;
+  labelCapacity = lastNode > 0 ? lastNode : 1;
+}//labelIndex------------------------------------------------------------------------------------
+
+//labelSift===========================================================
+//Moves "ownLabels[root]" down the heap of "count" entries.
+//The larger children go up all the way down to a leaf (one comparison
+//a level), then it climbs back to it's place : taken from the bottom
+//of the heap, it seldom goes far, so this halves the comparisons.
+//--------------------------------------------------------------------
+void MenuTree::labelSift(int root, int count) {
+  menuIndex moved = ownLabels[root];
+  int hole = root;
+  while (2 * hole + 2 < count) {                                     //Down,
+    int child = 2 * hole + 1;
+    if (labelOrder(ownLabels[child], ownLabels[child + 1]) < 0) child++;
+    ownLabels[hole] = ownLabels[child];
+    hole = child;
+  }
+  if (2 * hole + 1 < count) {                                        //(an only child)
+    ownLabels[hole] = ownLabels[2 * hole + 1];
+    hole = 2 * hole + 1;
+  }
+  while (hole > root && labelOrder(ownLabels[(hole - 1) / 2], moved) < 0) {  //then up.
+    ownLabels[hole] = ownLabels[(hole - 1) / 2];
+    hole = (hole - 1) / 2;
+  }
+  ownLabels[hole] = moved;
+}//labelSift----------------------------------------------------------
+
+//labelOrder========================================================
+//The order of the labels of nodes "a" and "b" in "byLabel[]" :
+//ignoring case, then by node number. (<0 : "a" first, >0 : "b" first)
+//------------------------------------------------------------------
+int MenuTree::labelOrder(int a, int b) const {
+  int posA = nodes[a].start, posB = nodes[b].start;
+  int endA = posA + nodes[a].length, endB = posB + nodes[b].length;
+  if (!MYflash && endA <= MYlength && endB <= MYlength) {            //Both in the menu, in RAM : straight from it.
+    const char *textA = MYtext + posA, *textB = MYtext + posB;
+    int length = (endA - posA < endB - posB) ? endA - posA : endB - posB;
+    for (int i = 0; i < length; i++) {
+      if (textA[i] == textB[i]) continue;                                //(Most chars are the same : no toupper().)
+      int diff = toupper(textA[i]) - toupper(textB[i]);
+      if (diff != 0) return diff;
+    }
+    posA += length; posB += length;
+  }
+  while (posA < endA && posB < endB) {
+    int diff = toupper(itemChar(posA++)) - toupper(itemChar(posB++));
+    if (diff != 0) return diff;
+  }
+  if (posA < endA) return 1;                //"b" is shorter.
+  if (posB < endB) return -1;               //"a" is shorter.
+  return a - b;
+}//labelOrder-------------------------------------------------------
+
+//editable==============================================================================
+//Before a change : "nodes[]" and "byLabel[]" are copied in RAM if they are not owned
+//(a MENU_TABLE or a MenuImage). Returns false if there is not enough memory.
+//--------------------------------------------------------------------------------------
+bool MenuTree::editable() {
+  if (nodeCapacity == 0) {
+    hiddenCount = 0;
+    for (int i = 1; i <= lastNode; i++) {                              //(An image may have hidden items.)
+      if ((nodes[i].flags & (MENU_HIDDEN | MENU_REMOVED)) == MENU_HIDDEN && !hiddenAdd(i)) return false;
+    }
+    node *table = (node*) malloc((lastNode + 1) * sizeof(node));
+    if (!table) return false;
+    memcpy(table, nodes, (lastNode + 1) * sizeof(node));
+    ownNodes = MenuMemory<node>();
+    ownNodes = table;
+    nodes = ownNodes;
+    nodeCapacity = lastNode + 1;
+  }
+  if (labelCapacity == 0) {
+    menuIndex *sorted = (menuIndex*) malloc((labelCount > 0 ? labelCount : 1) * sizeof(menuIndex));
+    if (!sorted) return false;
+    if (labelCount > 0) memcpy(sorted, byLabel, labelCount * sizeof(menuIndex));
+    ownLabels = MenuMemory<menuIndex>();
+    ownLabels = sorted;
+    byLabel = ownLabels;
+    labelCapacity = labelCount > 0 ? labelCount : 1;
+  }
+  return true;
+}//editable-----------------------------------------------------------------------------
+
+//newNode==============================================================
+//A free node : a removed one, or one more at the end of "nodes[]"
+//(twice as many allocated at a time). Returns 0 if there is none left.
+//---------------------------------------------------------------------
+int MenuTree::newNode() {
+  int item = freeNode;
+  if (item != 0) freeNode = ownNodes[item].previous;                 //A removed one,
+  else {
+    if (lastNode >= MENU_MAX_ITEMS) return 0;                         //(as many as the node numbers can hold)
+    if (lastNode + 1 >= nodeCapacity) {                               //or one more.
+      long capacity = menuGrow(nodeCapacity, lastNode + 2, MENU_MAX_ITEMS + 1, sizeof(node));
+      node *table = capacity > lastNode + 1 ? (node*) realloc(ownNodes, capacity * sizeof(node)) : 0;
+      if (!table) return 0;
+      ownNodes = table;
+      nodes = ownNodes;
+      nodeCapacity = capacity;
+    }
+    item = ++lastNode;
+    ownNodes[item] = node();
+    return item;
+  }
+  node removed = ownNodes[item];
+  ownNodes[item] = node();
+  if ((long) removed.start >= MYlength) {                            //The room of it's label in "ownExtra"
+    ownNodes[item].start = removed.start;                              //is used again (see setLabel()).
+    ownNodes[item].length = removed.length;
+  }
+  return item;
+}//newNode-------------------------------------------------------------
+
+//setLabel=============================================================================
+//Stores "label" (up to 255 chars : false if it's longer) after the menu, in "ownExtra", for "item".
+//A label that was already there is replaced in place if the new one is not longer.
+//-------------------------------------------------------------------------------------
+bool MenuTree::setLabel(int item, const char *label) {
+  if (strlen(label) > 255) return false;                             //(The length of a label is a byte.)
+  int length = strlen(label);
+  node &n = ownNodes[item];
+  long at = (long) n.start - MYlength;                               //Where it was,
+  if (at < 0 || n.length < length) {                                 //or at the end.
+    if (MYlength + extraLength + length > MENU_MAX_LENGTH) return false;  //(As far as "start" and "pos" can go.)
+    if (extraLength + length > extraCapacity) {
+      long capacity = menuGrow(extraCapacity ? extraCapacity : 32, extraLength + length, MENU_MAX_LENGTH - MYlength, 1);
+      char *extra = (char*) realloc(ownExtra, capacity);
+      if (!extra) return false;
+      ownExtra = extra;
+      extraCapacity = capacity;
+    }
+    at = extraLength;
+    extraLength += length;
+  }
+  memcpy(ownExtra + at, label, length);
+  n.start = MYlength + at;
+  n.length = length;
+  return true;
+}//setLabel----------------------------------------------------------------------------
+
+//link=================================================================================
+//Puts "item" amongst the children of "parent", at "rank" (past the youngest : the youngest).
+//The siblings that come after it are renumbered.
+//-------------------------------------------------------------------------------------
+void MenuTree::link(int item, int parent, int rank) {
+  node *n = ownNodes;
+  int count = n[parent].children;
+  if (rank < 1 || rank > count + 1) rank = count + 1;
+  n[item].parent = parent;
+  n[item].rank = rank;
+  n[parent].children++;
+  if (count == 0) {                                                  //The only child,
+    n[parent].eldest = item;
+    n[item].previous = item;
+    n[item].next = item;
+  }
+  else if (rank == 1) {                                              //the eldest (it knows the youngest),
+    int younger = n[parent].eldest;
+    n[parent].eldest = item;
+    n[item].previous = n[younger].previous;
+    n[item].next = younger;
+    n[younger].previous = item;
+    ranks(item);
+  }
+  else {                                                             //or after an older sibling
+    int older = n[parent].eldest;
+    if (rank == count + 1) older = n[older].previous;                  //(the youngest : known by the eldest).
+    while ((int) n[older].rank < rank - 1) older = n[older].next;
+    int younger = n[older].next;
+    n[item].previous = older;
+    if (younger == older) {                                            //The youngest :
+      n[item].next = item;
+      n[n[parent].eldest].previous = item;                               //the eldest knows it.
+    }
+    else {
+      n[item].next = younger;
+      n[younger].previous = item;
+    }
+    n[older].next = item;
+    ranks(item);
+  }
+}//link--------------------------------------------------------------------------------
+
+//unlink===========================================================
+//Takes "item" out of it's siblings (it keeps it's children).
+//The siblings that came after it are renumbered.
+//-----------------------------------------------------------------
+void MenuTree::unlink(int item) {
+  node *n = ownNodes;
+  int parent = n[item].parent, older = n[item].previous, younger = n[item].next;
+  n[parent].children--;
+  bool isEldest = (n[item].rank == 1);
+  if (isEldest && younger == item) n[parent].eldest = 1;             //The only child ("I have no child"),
+  else if (isEldest) {                                               //the eldest,
+    n[parent].eldest = younger;
+    n[younger].previous = older;                                       //(the youngest)
+    n[younger].rank = 1;
+    ranks(younger);
+  }
+  else if (younger == item) {                                        //the youngest,
+    n[older].next = older;
+    n[n[parent].eldest].previous = older;
+  }
+  else {                                                             //or in between.
+    n[older].next = younger;
+    n[younger].previous = older;
+    ranks(older);
+  }
+}//unlink----------------------------------------------------------
+
+//ranks================================================
+//Renumbers the siblings after "from".
+//-----------------------------------------------------
+void MenuTree::ranks(int from) {
+  node *n = ownNodes;
+  while ((int) n[from].next != from) {
+    int younger = n[from].next;
+    n[younger].rank = n[from].rank + 1;
+    from = younger;
+  }
+}//ranks-----------------------------------------------
+
+//release==================================================================================
+//Frees "item" and it's submenu (already unlinked) : out of "byLabel[]", on the free list.
+//The hidden items in there are out of their siblings : each node freed gives it's own
+//from "ownHidden[]", and they are freed too (so that none of them can come back under
+//a node that is used again). Only the submenu is visited.
+//-----------------------------------------------------------------------------------------
+void MenuTree::release(int item) {
+  node *n = ownNodes;
+  if (n[item].flags & MENU_HIDDEN) hiddenRemove(item);
+  int checked = freeNode;                                            //(Freed before.)
+  releaseLinked(item);
+  while (freeNode != checked) {                                      //The nodes just freed,
+    int last = freeNode;
+    for (int at = last; at != checked; at = n[at].previous) {
+      int first = hiddenFind(at, 0);
+      while (first < hiddenCount && (int) n[ownHidden[first]].parent == at) {  //their hidden children,
+        int hidden = ownHidden[first];
+        hiddenRemove(hidden);
+        releaseLinked(hidden);                                           //and the submenus of those (next round).
+      }
+    }
+    checked = last;
+  }
+}//release---------------------------------------------------------------------------------
+
+//releaseLinked============================================================================
+//Frees "item" and the submenu linked under it.
+//The submenu is walked thru "eldest", "next" and "parent" ("previous" links the free list).
+//-----------------------------------------------------------------------------------------
+void MenuTree::releaseLinked(int item) {
+  node *n = ownNodes;
+  int at = item;
+  while (true) {
+    labelRemove(at);
+    n[at].flags |= MENU_REMOVED;
+    n[at].previous = freeNode;
+    freeNode = at;
+    if (n[at].children > 0) { at = n[at].eldest; continue; }         //Down,
+    while (at != item && (int) n[at].next == at) at = n[at].parent;        //or up to an uncle,
+    if (at == item) return;
+    at = n[at].next;                                                 //or to the next sibling.
+  }
+}//releaseLinked---------------------------------------------------------------------------
+
+//labelAdd=============================================================
+//Puts "item" in "byLabel[]", where it's label goes (binary search).
+//---------------------------------------------------------------------
+bool MenuTree::labelAdd(int item) {
+  if (labelCount == labelCapacity) {
+    long capacity = menuGrow(labelCapacity, labelCount + 1, MENU_MAX_ITEMS, sizeof(menuIndex));
+    menuIndex *sorted = capacity > labelCount ? (menuIndex*) realloc(ownLabels, capacity * sizeof(menuIndex)) : 0;
+    if (!sorted) return false;
+    ownLabels = sorted;
+    byLabel = ownLabels;
+    labelCapacity = capacity;
+  }
+  int low = 0, high = labelCount;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (labelOrder(ownLabels[middle], item) < 0) low = middle + 1;
+    else                                        high = middle;
+  }
+  memmove(ownLabels + low + 1, ownLabels + low, (labelCount - low) * sizeof(menuIndex));
+  ownLabels[low] = item;
+  labelCount++;
+  return true;
+}//labelAdd------------------------------------------------------------
+
+//labelRemove========================================================
+//Takes "item" out of "byLabel[]" (binary search, by it's label).
+//-------------------------------------------------------------------
+void MenuTree::labelRemove(int item) {
+  int low = 0, high = labelCount;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (labelOrder(ownLabels[middle], item) < 0) low = middle + 1;
+    else                                        high = middle;
+  }
+  if (low == labelCount || (int) ownLabels[low] != item) return;
+  memmove(ownLabels + low, ownLabels + low + 1, (labelCount - low - 1) * sizeof(menuIndex));
+  labelCount--;
+}//labelRemove-------------------------------------------------------
+
+//hiddenFind======================================================================
+//Where "item", a hidden child of "parent", is in "ownHidden[]", or where it goes
+//(binary search : by parent, then by number). hiddenFind(parent, 0) : the first one.
+//---------------------------------------------------------------------------------
+int MenuTree::hiddenFind(int parent, int item) const {
+  int low = 0, high = hiddenCount;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    int at = ownHidden[middle];
+    int above = nodes[at].parent;
+    if (above < parent || (above == parent && at < item)) low = middle + 1;
+    else                                                  high = middle;
+  }
+  return low;
+}//hiddenFind----------------------------------------------------------------------
+
+//hiddenAdd============================================================
+//Puts "item" (being hidden) in "ownHidden[]". False : no memory left.
+//---------------------------------------------------------------------
+bool MenuTree::hiddenAdd(int item) {
+  if (hiddenCount == hiddenCapacity) {
+    long capacity = menuGrow(hiddenCapacity, hiddenCount + 1, MENU_MAX_ITEMS, sizeof(menuIndex));
+    menuIndex *table = capacity > hiddenCount ? (menuIndex*) realloc(ownHidden, capacity * sizeof(menuIndex)) : 0;
+    if (!table) return false;
+    ownHidden = table;
+    hiddenCapacity = capacity;
+  }
+  int at = hiddenFind(nodes[item].parent, item);
+  memmove(ownHidden + at + 1, ownHidden + at, (hiddenCount - at) * sizeof(menuIndex));
+  ownHidden[at] = item;
+  hiddenCount++;
+  return true;
+}//hiddenAdd-----------------------------------------------------------
+
+//hiddenRemove==================================================
+//Takes "item" (shown again, or freed) out of "ownHidden[]".
+//--------------------------------------------------------------
+void MenuTree::hiddenRemove(int item) {
+  int at = hiddenFind(nodes[item].parent, item);
+  if (at == hiddenCount || (int) ownHidden[at] != item) return;
+  memmove(ownHidden + at, ownHidden + at + 1, (hiddenCount - at - 1) * sizeof(menuIndex));
+  hiddenCount--;
+}//hiddenRemove-------------------------------------------------
+
+//labelCompare=======================================================================
+//Compares the label of "node" to the "length" first chars of "find", ignoring case.
+//(<0 : the label comes first, >0 : "find" comes first, 0 : same)
+//If "prefix", a label that starts with "find" is the same.
+//-----------------------------------------------------------------------------------
+int Menu::labelCompare(int node, const char *find, int length, bool prefix) {
+  int pos = nodes[node].start;
+  int end = pos + nodes[node].length;
+  for (int i = 0; i < length; i++, pos++) {
+    if (pos == end) return -1;                //The label is shorter.
+    int diff = toupper(itemChar(pos)) - toupper(find[i]);
+    if (diff != 0) return diff;
+  }
+  if (!prefix && pos < end) return 1;       //The label is longer.
+  return 0;
+}//labelCompare----------------------------------------------------------------------
+
+//labelFirst=======================================================================
+//The first entry of "byLabel[]" whose label is not before "find" (binary search).
+//---------------------------------------------------------------------------------
+int Menu::labelFirst(const char *find, int length, bool prefix) {
+  int low = 0, high = labelCount;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (labelCompare(byLabel[middle], find, length, prefix) < 0) low = middle + 1;
+    else                                                          high = middle;
+  }
+  return low;
+}//labelFirst----------------------------------------------------------------------
+
+//itemNumber===========================================================
+//Returns the number of the first menu item with label "find",
+//or 0 if there is none. (Hidden items are found too, see enableItem().)
+//---------------------------------------------------------------------
+int Menu::itemNumber(const char *find) {
+  int length = strlen(find);
+  for (int i = labelFirst(find, length, false); i < labelCount; i++) {   //The labels that are the same, ignoring case,
+    if (labelCompare(byLabel[i], find, length, false) != 0) break;     //sorted by node number :
+    int pos = nodes[byLabel[i]].start;                                 //the first one that is exactly the same.
+    int j = 0;
+    while (j < length && itemChar(pos + j) == find[j]) j++;
+    if (j == length) return byLabel[i];
+  }
+  return 0;
+}//itemNumber----------------------------------------------------------
+
+#if defined(ARDUINO)
+//itemNumber======================================
+//Same, with a String.
+//------------------------------------------------
+int Menu::itemNumber(String find) {
+  return itemNumber(find.c_str());
+}//itemNumber-------------------------------------
+#endif
+
+//typeAhead=================================================================================
+//A key was typed : add it to what was typed so far, and jump to the next item
+//whose label starts with it (ignoring case), after the current item (wrapping around).
+//If nothing starts with what was typed, start over with this key alone.
+//Returns the new current item, or 0 if nothing matches (the current item does not change).
+//------------------------------------------------------------------------------------------
+int Menu::typeAhead(char key) {
+  if (typedLength == MENU_TYPEAHEAD) typedLength = 0;       //Too much typed : start over.
+  typed[typedLength++] = key;
+  int first = labelFirst(typed, typedLength, true);
+  if ((first == labelCount || labelCompare(byLabel[first], typed, typedLength, true) != 0) && typedLength > 1) {
+    typed[0] = key; typedLength = 1;                         //Nothing matches : start over with this key.
+    first = labelFirst(typed, typedLength, true);
+  }
+  int found = 0;                                             //The first match after the current item,
+  int lowest = 0;                                            //or the first match of all.
+  for (int i = first; i < labelCount && labelCompare(byLabel[i], typed, typedLength, true) == 0; i++) {
+    int node = byLabel[i];
+    if (itemFlags(node) != 0) continue;                      //Hidden (see enableItem()).
+    if (node == currentNode && typedLength > 1) { found = node; break; }  //Still matches : stay there.
+    if (node > currentNode && (found == 0 || node < found)) found = node;
+    if (lowest == 0 || node < lowest) lowest = node;
+  }
+  if (found == 0) found = lowest;
+  if (found == 0) { typedLength = 0; return 0; }
+  if (list) listLeave();
+  if (found != currentNode) { currentNode = found; needsUpdate = true; }
+  return found;
+}//typeAhead--------------------------------------------------------------------------------
+
+//typeAheadReset============================================
+//Forget what was typed : the next key starts a new search.
+//----------------------------------------------------------
+void Menu::typeAheadReset() {
+  typedLength = 0;
+}//typeAheadReset-------------------------------------------
+
+//selectItem============================================================
+//Moves the pointer to node "number".
+//Returns false (and stays) if there is no such item in the menu, or if it
+//can't be reached (removed, hidden, or in a hidden submenu : see itemFlags()).
+//----------------------------------------------------------------------
+bool Menu::selectItem(int number) {
+  if (number < 1 || number > lastNode || itemFlags(number) != 0) return false;
+  listLeave();
+	currentNode = number;
+  needsUpdate = true;
+  return true;
+}//selectItem-----------------------------------------------------------
+
+//parent===================================================
+//Return the number of the parent of "node".
+//---------------------------------------------------------
+int Menu::parent(int node) {
+    return nodes[node].parent;
+}//parent--------------------------------------------------
+
+//eldest============================================
+//Return the number of the eldest child of "node".
+//--------------------------------------------------
+int Menu::eldest(int node) {
+  return nodes[node].eldest;
+}//eldest-------------------------------------------
+
+//previousSibling===================================================
+//If "node" is the eldest, return "node".
+//Otherwise, return it's older sibling.
+//------------------------------------------------------------------
+int Menu::previousSibling(int node) {
+  return (nodes[node].rank == 1) ? node : nodes[node].previous;   //(The eldest's "previous" is the youngest.)
+}//previousSibling--------------------------------------------------
+
+//youngest======================================================
+//Return the number of the youngest child of "node" (it has one).
+//--------------------------------------------------------------
+int Menu::youngest(int node) {
+  return nodes[nodes[node].eldest].previous;
+}//youngest-----------------------------------------------------
+
+//nextSibling=====================================================
+//Return the next sibling of "node",
+//or "node" if it is the youngest.
+//----------------------------------------------------------------
+int Menu::nextSibling(int node) {
+  return nodes[node].next;
+}//nextSibling----------------------------------------------------
+
+//rank===========================================================
+//Returs the rank of "node" amongst it's siblings.
+//---------------------------------------------------------------
+int Menu::rank(int node) {
+  return nodes[node].rank;
+}//rank----------------------------------------------------------
+
+//siblingsCount========================================================================
+//returns the number of siblings of "node".
+//-------------------------------------------------------------------------------------
+int Menu::siblingsCount(int node) {
+  return nodes[parent(node)].children;
+}//siblingsCount------------------------------------------------------------------------
+
+ //getCurrentItem==========================================
+ //Returns the to the current node.
+ //---------------------------------------------------
+int Menu::getCurrentItem() {
+	return currentNode;
+}//getCurrentItem-----------------------------------------
+
+//getAction==========================================
+//Returns the action associated to the current node.
+//---------------------------------------------------
+int Menu::getAction() {
+  if (list) return list->action(listCurrent);
+  return nodes[currentNode].action;
+}//getAction-----------------------------------------
+
+#if defined(ARDUINO)
+//getCurrentLabel========================
+//Returns the label of the current item.
+//---------------------------------------
+String Menu::getCurrentLabel() {
+  return label(list ? listCurrent + 1 : currentNode);
+}//getCurrentLabel-----------------------
+#endif
+
+//getCurrentLabel===========================================================
+//Returns a pointer to the label of the current item, right in the menu.
+//The label is NOT terminated by a '\0' : "length" receives its length.
+//"inFlash" tells where it is : true, a PROGMEM address (use pgm_read_byte()),
+//false, RAM. A menu in flash has both : the labels added by insertItem()
+//or changed by renameItem() are in RAM. In a list, this is the copy kept
+//by the Menu (at most LCDcol chars), in RAM.
+//--------------------------------------------------------------------------
+const char *Menu::getCurrentLabel(int &length, bool &inFlash) {
+  inFlash = false;
+  if (list) {
+    int slot = listEntry(listCurrent);
+    length = slot < 0 ? 0 : listCache[slot].length;
+    return slot < 0 ? "" : listText + slot * LCDcol;
+  }
+  length = nodes[currentNode].length;
+  if ((long) nodes[currentNode].start >= MYlength) return MYextra + (nodes[currentNode].start - MYlength);  //Added or changed.
+  inFlash = MYflash;
+  return MYtext + nodes[currentNode].start;
+}//getCurrentLabel----------------------------------------------------------
+
+//getCurrentLabel============================================================
+//The same, for a menu in RAM : with a menu in flash, use the one above.
+//---------------------------------------------------------------------------
+const char *Menu::getCurrentLabel(int &length) {
+  bool inFlash;
+  return getCurrentLabel(length, inFlash);
+}//getCurrentLabel-----------------------------------------------------------
+
+//done================================================================================================
+//Allows the sketch to signal the library that the action is finished and that we return to the menu.
+//----------------------------------------------------------------------------------------------------
+void Menu::done() {
+	needsUpdate = true;
+  lcdInvalidate();      //The action may have written anywhere on the LCD.
+}//done-----------------------------------------------------------------------------------------------
+
+//restart==================
+//Reinitialise the menu.
+//-------------------------
+void Menu::reset() {
+  listLeave();
+  currentNode = nodes[0].eldest;    //The first item (1, unless it was removed).
+}//restart-----------------
+
+//updated===============================
+//Signals that the LCD has been updated.
+//--------------------------------------
+void Menu::LcdUpdated() {
+  MENU_STAT(if (needsUpdate) statistics.redraws++);
+  needsUpdate = false;
+  shownCaret = -1;
+  for (int row = 0; row < LCDrows; row++) {     //Remember what is now on each row.
+    bool caret;
+    shown[row] = lineItem(row, caret);
+    if (caret) shownCaret = row;
+  }
+}//updated------------------------------
+
+//needsUpdate========================================
+//Returns whether the LCD needs to be updated or not.
+//---------------------------------------------------
+bool Menu::LcdNeedsUpdate() {
+  return needsUpdate;
+}//needsUpdate---------------------------------------
+
+//updateLcd==================================
+//Signal that the LCD needs to be updated.
+//-------------------------------------------
+void Menu::updateLcd() {
+	needsUpdate = true;
+  lcdInvalidate();
+  if (list) listRefresh();  //The entries of a list may have changed too.
+}//updateLcd---------------------------------
+
+//lcdInvalidate=======================================================
+//Forget what is on the LCD : every row will have to be fully redrawn.
+//--------------------------------------------------------------------
+void Menu::lcdInvalidate() {
+  for (int row = 0; row < LCDrows; row++) shown[row] = -1;
+  shownCaret = -1;
+}//lcdInvalidate------------------------------------------------------
+
+//lcdChar==========================================================================
+//The character at column "col" of a row that shows "item" (0 : an empty row).
+//"caret" : the row shows the current item.
+//---------------------------------------------------------------------------------
+char Menu::lcdChar(long item, bool caret, int col) {
+  if (item == 0) return ' ';
+  if (col == 0) return caret ? '>' : ' ';
+  return (col - 1 < itemLength(item)) ? itemLabel(item, col - 1) : ' ';
+}//lcdChar-------------------------------------------------------------------------
+
+//lcdDamage=================================================================================
+//Which rows changed since the last LcdUpdated() : bit "row" is set if "row" must be redrawn.
+//------------------------------------------------------------------------------------------
+unsigned long Menu::lcdDamage() {
+  unsigned long rows = 0;
+  int first, last;
+  for (int row = 0; row < LCDrows && row < 32; row++) {
+    if (lcdDamage(row, first, last)) rows |= 1UL << row;
+  }
+  return rows;
+}//lcdDamage--------------------------------------------------------------------------------
+
+//lcdDamage=======================================================================================
+//Did "row" change since the last LcdUpdated()?
+//If so, "first" and "last" receive the first and last columns that changed, and true is returned.
+//Moving the caret inside the LCD changes only column 0 of two rows.
+//Scrolling changes the rows whose text changed, and only where it changed.
+//------------------------------------------------------------------------------------------------
+bool Menu::lcdDamage(int row, int &first, int &last) {
+  if (row < 0 || row >= LCDrows) return false;
+  if (shown[row] < 0) {                                         //Unknown : the whole row.
+    first = 0; last = LCDcol - 1;
+    return true;
+  }
+  bool caret;
+  long item = lineItem(row, caret);                             //What should be on the row,
+  bool hadCaret = (shownCaret == row);                          //what was there.
+  if (item == shown[row]) {                                     //Same item :
+    if (caret == hadCaret) return false;                          //nothing changed,
+    first = 0; last = 0;                                          //or only the caret.
+    return true;
+  }
+  first = -1;
+  for (int col = 0; col < LCDcol; col++) {                      //Compare both rows, one char at a time.
+    if (lcdChar(item, caret, col) != lcdChar(shown[row], hadCaret, col)) {
+      if (first < 0) first = col;
+      last = col;
+    }
+  }
+  return first >= 0;
+}//lcdDamage--------------------------------------------------------------------------------------
+
+//defineLcd====================================================
+//The number of columns and lines of the sketche's LCD.
+//An LCD without a row or a column is refused, and without the
+//memory for the rows (error() : NO_MEMORY), the LCD stays as
+//it was : returns false.
+//-------------------------------------------------------------
+bool Menu::defineLcd(int columns, int rows) {
+  if (columns < 1 || rows < 1) return false;
+  long *rowItems = (long*) realloc(shown, rows * sizeof(long));  //What is shown on each row.
+  if (!rowItems) {
+    if (!shown) LCDrows = 0;                            //(No row yet : none can be drawn.)
+    if (treeError.code == MenuTable::NONE) treeError.code = MenuTable::NO_MEMORY;
+    return false;
+  }
+  shown = rowItems;
+	LCDcol = columns; //Number of columns of the sketche's LCD
+	LCDrows = rows;   //Number of rows of the sketche's LCD
+  lcdInvalidate();
+  if (list) listRefresh();                              //The copies of the labels of a list depend on the LCD.
+  return true;
+}//defineLcd---------------------------------------------------
+
+//lineItem=================================================================================================================================
+//Returns the item to be displayed on the "requested Line" on the lcd for the current menu or submenu,
+//or 0 if there is no item at this line.
+//The item is a node, or, in a list, the index of an entry + 1.
+//"caret" is set to true if the item is the current item.
+//-----------------------------------------------------------------------------------------------------------------------------------------
+long Menu::lineItem(int requestedLine, bool &caret) {
+  long currentRank, count;
+  if (list) { currentRank = listCurrent + 1;    count = listCount; }                    //In a list,
+  else      { currentRank = rank(currentNode);  count = siblingsCount(currentNode); }   //or amongst it's siblings.
+  caret = false;
+  if((requestedLine + 1) > count) return 0;                         //There is no item at this rank in the menu.
+	long targetRank = requestedLine + 1;                              //Case where the LCD line 0 displays the eldest.
+	if (currentRank >= LCDrows) targetRank += currentRank - LCDrows;  //If not, add the difference between the the item and LCD's line count.
+  long found = (targetRank < count) ? targetRank : count;           //The youngest is the last one that can be found.
+  caret = (currentRank == targetRank);                              //Is it the current item?
+  if (list) return found;                                           //The entry of the list at "targetRank".
+	int child = currentNode;                                          //From the current node,
+  long steps = count;                                               //(no further than the siblings go)
+  while (rank(child) < found && steps-- > 0) child = nextSibling(child);      //Walk down (never more than the LCD's rows)
+  while (rank(child) > found && steps-- > 0) child = previousSibling(child);  //or up to the item at "targetRank".
+  return child;
+}//lineItem---------------------------------------------------------------------------------------------------------------------------------
+
+//itemLength=================================================
+//The length of the label of "item" (see lineItem()).
+//-----------------------------------------------------------
+int Menu::itemLength(long item) {
+  if (list) {
+    int slot = listEntry(item - 1);
+    return slot < 0 ? 0 : listCache[slot].length;
+  }
+  return nodes[item].length;
+}//itemLength------------------------------------------------
+
+//itemLabel==================================================
+//The char at "pos" in the label of "item" (see lineItem()).
+//-----------------------------------------------------------
+char Menu::itemLabel(long item, int pos) {
+  if (list) {
+    int slot = listEntry(item - 1);
+    return slot < 0 ? ' ' : listText[slot * LCDcol + pos];
+  }
+  return itemChar(nodes[item].start + pos);
+}//itemLabel-------------------------------------------------
+
+
+#if defined(ARDUINO)
+//lcdLine==================================================================================================================================
+//Return a string containing the label of the item to be displayed
+//on the "requested Line" on the lcd for the current menu or submenu.
+//Preceded by a caret ">" if the item is the current item.
+//-----------------------------------------------------------------------------------------------------------------------------------------
+String Menu::lcdLine(int requestedLine) {
+  bool caret;
+  long child = lineItem(requestedLine, caret);                      //The item on that line.
+  if (child == 0) return "";                                        //There is no item at this rank in the menu.
+  MENU_STAT(statistics.strings++);                                  //The caret and the label make a second String.
+	if (caret) return '>' + label(child);                             //If it is the curent item, add a ">" before the label.
+	else       return ' ' + label(child);                             //If not, add a " " before the label.
+}//cdLine-----------------------------------------------------------------------------------------------------------------------------------
+#endif
+
+//lcdLine==================================================================================================================================
+//Write in "buffer" the line to be displayed on the "requested Line" on the lcd for the current menu or submenu.
+//The label is preceded by a caret ">" if the item is the current item (a " " if not).
+//The line is padded with spaces (or truncated) to exactly LCDcol characters, followed by a '\0'.
+//"buffer" must hold at least LCDcol + 1 chars. No String is built, nothing is allocated.
+//-----------------------------------------------------------------------------------------------------------------------------------------
+void Menu::lcdLine(int requestedLine, char *buffer) {
+  bool caret;
+  long child = lineItem(requestedLine, caret);                      //The item on that line (0 : none).
+  int col = 0;
+  if (child != 0 && LCDcol > 0) {
+    buffer[col++] = caret ? '>' : ' ';                                //The caret, or a space.
+    int length = itemLength(child);
+    for (int i = 0; i < length && col < LCDcol; i++) {
+      buffer[col++] = itemLabel(child, i);                            //The label, right from the menu (or the list).
+    }
+  }
+  while (col < LCDcol) buffer[col++] = ' ';                         //Pad with spaces to erase what was there.
+  buffer[col] = '\0';
+}//lcdLine----------------------------------------------------------------------------------------------------------------------------------
+
+//mapKeyChar===========================================================
+//This is used if the keypad returns characters.
+//Most matrix keypads use this scheme.
+//---------------------------------------------------------------------
+void Menu::mapKeyChar(char UP, char DOWN, char LEFT, char RIGHT) {
+  keysAreChars = true;  //For update(const MenuKey *keys, int count).
+  for (byte command = MENU_UP; command <= MENU_RIGHT; command++) keyForget(command, true);  //Replaces the previous ones.
+	keyBind((unsigned char) UP, true, MENU_UP);
+	keyBind((unsigned char) DOWN, true, MENU_DOWN);
+	keyBind((unsigned char) LEFT, true, MENU_LEFT);
+	keyBind((unsigned char) RIGHT, true, MENU_RIGHT);
+}//mapKeyChars---------------------------------------------------------
+
+ //mapKeyint-===========================================================
+ //This is used if the keypad returns integers.
+ //---------------------------------------------------------------------
+void Menu::mapKeyInt(int UP, int DOWN, int LEFT, int RIGHT) {
+  keysAreChars = false; //For update(const MenuKey *keys, int count).
+  for (byte command = MENU_UP; command <= MENU_RIGHT; command++) keyForget(command, false);  //Replaces the previous ones.
+	keyBind(UP, false, MENU_UP);
+	keyBind(DOWN, false, MENU_DOWN);
+	keyBind(LEFT, false, MENU_LEFT);
+	keyBind(RIGHT, false, MENU_RIGHT);
+}//mapKeyInt---------------------------------------------------------
+
+//mapKey===================================================================================
+//Binds "key" to "command" (see MenuCommand), on top of the keys already bound :
+//several keys can do the same thing (a keypad, a rotary encoder, a serial console...).
+//A key does one thing : binding it again replaces it's command. MENU_NONE unbinds it.
+//Returns false if there is no room left (see MENU_KEYS) or if "key" is 0 (no key).
+//-----------------------------------------------------------------------------------------
+bool Menu::mapKey(int key, MenuCommand command) {
+  return keyBind(key, false, command);
+}//mapKey----------------------------------------------------------------------------------
+
+//mapKey=========================================
+//Same, for keys that are chars.
+//-----------------------------------------------
+bool Menu::mapKey(char key, MenuCommand command) {
+  return keyBind((unsigned char) key, true, command);
+}//mapKey----------------------------------------
+
+//keyCommand=========================================================
+//The command bound to "key" (MENU_NONE : none) : straight to it's
+//entry in "keyMap[]", or in the next ones if others got there first.
+//-------------------------------------------------------------------
+int Menu::keyCommand(int key, bool isChar) {
+  int at = (unsigned int) key % MENU_KEYS;
+  for (int i = 0; i < MENU_KEYS && keyMap[at].command != MENU_NONE; i++) {
+    if (keyMap[at].key == key && keyMap[at].isChar == isChar) return keyMap[at].command;
+    at = (at + 1) % MENU_KEYS;
+  }
+  return MENU_NONE;
+}//keyCommand--------------------------------------------------------
+
+//keyBind==================================================================
+//Binds "key" to "command" (MENU_NONE : unbinds it).
+//When an entry is emptied, the entries after it are put back in place,
+//so that keyCommand() can stop at the first empty entry.
+//-------------------------------------------------------------------------
+bool Menu::keyBind(int key, bool isChar, byte command) {
+  if (key == 0) return false;
+  int at = (unsigned int) key % MENU_KEYS;
+  int i = 0;
+  while (i < MENU_KEYS && keyMap[at].command != MENU_NONE && !(keyMap[at].key == key && keyMap[at].isChar == isChar)) {
+    at = (at + 1) % MENU_KEYS;
+    i++;
+  }
+  if (i == MENU_KEYS) return command == MENU_NONE;                  //Full (and not there).
+  if (command != MENU_NONE) {                                       //Bind it (again),
+    keyMap[at].key = key;
+    keyMap[at].isChar = isChar;
+    keyMap[at].command = command;
+    return true;
+  }
+  if (keyMap[at].command == MENU_NONE) return true;                 //or unbind it.
+  keyMap[at].command = MENU_NONE;
+  at = (at + 1) % MENU_KEYS;
+  for (int j = 1; j < MENU_KEYS && keyMap[at].command != MENU_NONE; j++, at = (at + 1) % MENU_KEYS) {
+    int moved = keyMap[at].key;                                       //Put the next ones back in place.
+    bool movedIsChar = keyMap[at].isChar;
+    byte movedCommand = keyMap[at].command;
+    keyMap[at].command = MENU_NONE;
+    keyBind(moved, movedIsChar, movedCommand);
+  }
+  return true;
+}//keyBind-----------------------------------------------------------------
+
+//keyForget==============================================
+//Unbinds the keys (chars or not) bound to "command".
+//-------------------------------------------------------
+void Menu::keyForget(byte command, bool isChar) {
+  for (int i = 0; i < MENU_KEYS; i++) {
+    if (keyMap[i].command == command && keyMap[i].isChar == isChar) {
+      keyBind(keyMap[i].key, isChar, MENU_NONE);
+      i = -1;                                                       //(The entries may have moved.)
+    }
+  }
+}//keyForget---------------------------------------------
+
+//updateMenu=============================================================================
+//Sets as current, the new item according to the command (see MenuCommand).
+//Returns the action associated to the item.
+//UP, DOWN and LEFT sets the current node to, respectively:
+//the previous sibling, the next sibling and the parent of the current node.
+//For the RIGHT key, there are two possibilities :
+//- The action associated to the node needs to be carried out by the sketch. (>"000")
+//- The action is "000" and the current node becomes it's eldest child
+//PAGE_UP and PAGE_DOWN move by the rows of the LCD, HOME and END go to the eldest
+//and the youngest sibling, TOP to the first item of the menu : straight there, thru the links.
+//Raise the "needsUpdate" flag if the node changed.
+//---------------------------------------------------------------------------------------
+int Menu::updateMenu(int command) {
+  if (list) return updateList(command);
+  int node = currentNode;
+  switch (command) {
+    case MENU_UP:        currentNode = previousSibling(currentNode); break;
+    case MENU_DOWN:      currentNode = nextSibling(currentNode); break;
+    case MENU_LEFT:      if (parent(currentNode) != 0) currentNode = parent(currentNode); break;
+    case MENU_PAGE_UP:   for (int i = 0; i < LCDrows; i++) currentNode = previousSibling(currentNode); break;
+    case MENU_PAGE_DOWN: for (int i = 0; i < LCDrows; i++) currentNode = nextSibling(currentNode); break;
+    case MENU_HOME:      currentNode = eldest(parent(currentNode)); break;
+    case MENU_END:       currentNode = youngest(parent(currentNode)); break;
+    case MENU_TOP:       currentNode = eldest(0); break;
+    case MENU_RIGHT: {
+      MenuSource *source = sourceOf(currentNode);
+      if (source) { listEnter(source); return 0; }                  //The node holds a list : enter it.
+      int action = getAction();
+      if (action > 0) return action;
+      else            if (nodes[currentNode].children > 0) currentNode = eldest(currentNode);
+    }
+  }
+  if (currentNode != node) needsUpdate = true;
+	return 0;
+}//updateMenu-----------------------------------------------------------------------------
+
+//attachSource=======================================================================================
+//The children of "node" are the entries of "source" : they are asked for when needed,
+//never all kept in memory. (Files on an SD card, sensors, logs, ... even millions of them.)
+//RIGHT on "node" enters the list, LEFT leaves it. RIGHT on an entry returns source->action(entry).
+//A null "source" detaches the list. Returns false if MENU_SOURCES lists are already attached.
+//----------------------------------------------------------------------------------------------------
+bool Menu::attachSource(int node, MenuSource *source) {
+  int slot = -1;
+  for (int i = 0; i < MENU_SOURCES; i++) {
+    if (sources[i].source != 0 && sources[i].node == (menuIndex) node) { slot = i; break; }   //Already attached,
+    if (sources[i].source == 0 && slot < 0) slot = i;                            //or a free slot.
+  }
+  if (slot < 0) return false;
+  if (list && list == sources[slot].source) listLeave();
+  sources[slot].node = node;
+  sources[slot].source = source;
+  return true;
+}//attachSource---------------------------------------------------------------------------------------
+
+//sourceOf=====================================================
+//The list attached to "node" (0 if none).
+//-------------------------------------------------------------
+MenuSource *Menu::sourceOf(int node) {
+  for (int i = 0; i < MENU_SOURCES; i++) {
+    if (sources[i].source != 0 && sources[i].node == (menuIndex) node) return sources[i].source;
+  }
+  return 0;
+}//sourceOf----------------------------------------------------
+
+//getListIndex========================================================
+//Returns the index of the current entry of a list (-1 : not in a list).
+//The current item (getCurrentItem()) is then the node holding the list.
+//--------------------------------------------------------------------
+long Menu::getListIndex() {
+  return list ? listCurrent : -1;
+}//getListIndex-------------------------------------------------------
+
+//listEnter=============================================================================
+//Enter the list "source". Only a few labels are kept : 2 per row of the LCD.
+//--------------------------------------------------------------------------------------
+void Menu::listEnter(MenuSource *source) {
+  long count = source->count();
+  if (count <= 0) return;                                     //Nothing to see.
+  list = source;
+  listCount = count;
+  listCurrent = 0;
+  listRefresh();
+  lcdInvalidate();                                            //Everything changes on the LCD.
+  needsUpdate = true;
+}//listEnter----------------------------------------------------------------------------
+
+//listLeave====================================
+//Leave the list (if any) for the node holding it.
+//---------------------------------------------
+void Menu::listLeave() {
+  if (!list) return;
+  list = 0;
+  listCache = MenuMemory<listCopy>();
+  listText = MenuMemory<char>();
+  lcdInvalidate();
+  needsUpdate = true;
+}//listLeave-----------------------------------
+
+//listRefresh=========================================================
+//(Re)build the copies of the labels : empty, sized for the LCD.
+//Without the memory for them (or without a row), there is no copy :
+//the entries are shown without their labels (error() : NO_MEMORY).
+//--------------------------------------------------------------------
+void Menu::listRefresh() {
+  listCount = list->count();
+  if (listCurrent >= listCount) listCurrent = listCount > 0 ? listCount - 1 : 0;
+  int entries = 2 * LCDrows;
+  listCopy *copies = entries > 0 ? (listCopy*) realloc(listCache, entries * sizeof(listCopy)) : 0;
+  if (copies) listCache = copies;
+  char *text = copies ? (char*) realloc(listText, entries * LCDcol) : 0;
+  if (text) listText = text;
+  listEntries = text ? entries : 0;
+  if (entries > 0 && !text && treeError.code == MenuTable::NONE) treeError.code = MenuTable::NO_MEMORY;
+  for (int i = 0; i < listEntries; i++) listCache[i].index = -1;
+  listNext = 0;
+}//listRefresh--------------------------------------------------------
+
+//listEntry================================================================
+//The copy of the label of entry "index". If it is not there, ask for it
+//and replace the oldest copy (a ring). -1 : there is no copy (see listRefresh()).
+//-------------------------------------------------------------------------
+int Menu::listEntry(long index) {
+  if (listEntries == 0) return -1;
+  for (int i = 0; i < listEntries; i++) if (listCache[i].index == index) return i;
+  int slot = listNext;
+  listNext = (listNext + 1) % listEntries;
+  int length = list->label(index, listText + slot * LCDcol, LCDcol);
+  if (length < 0) length = 0;
+  if (length > LCDcol) length = LCDcol;
+  listCache[slot].index = index;
+  listCache[slot].length = length;
+  return slot;
+}//listEntry---------------------------------------------------------------
+
+//updateList==========================================================
+//updateMenu(), in a list.
+//UP and DOWN (PAGE_UP, PAGE_DOWN, HOME, END) move amongst the entries, LEFT leaves the list,
+//TOP leaves it for the first item of the menu and RIGHT returns the action of the entry.
+//--------------------------------------------------------------------
+int Menu::updateList(int command) {
+  long entry = listCurrent;
+  switch (command) {
+    case MENU_UP:        if (listCurrent > 0) listCurrent--; break;
+    case MENU_DOWN:      if (listCurrent < listCount - 1) listCurrent++; break;
+    case MENU_PAGE_UP:   listCurrent = (listCurrent > LCDrows) ? listCurrent - LCDrows : 0; break;
+    case MENU_PAGE_DOWN: listCurrent = (listCurrent + LCDrows < listCount) ? listCurrent + LCDrows : listCount - 1; break;
+    case MENU_HOME:      listCurrent = 0; break;
+    case MENU_END:       listCurrent = listCount - 1; break;
+    case MENU_LEFT:      listLeave(); break;
+    case MENU_TOP:       listLeave(); currentNode = eldest(0); break;
+    case MENU_RIGHT: {
+      int action = list->action(listCurrent);
+      if (action > 0) return action;
+    }
+  }
+  if (listCurrent < 0) listCurrent = 0;                             //(An empty list.)
+  if (list && listCurrent != entry) needsUpdate = true;
+  return 0;
+}//updateList---------------------------------------------------------
+
+//insertItem============================================================================================
+//Adds an item to the menu : "label" (up to 255 chars, copied), "action" (0 to 999, 0 : it has a submenu).
+//It goes amongst the children of "parent" (0 : the top of the menu), at "rank" (1 : the eldest,
+//past the youngest : the youngest). An item with an action (not 0) does not open it's submenu.
+//Returns the number of the new item, 0 if it could not be added (shared tree, no memory left,
+//MENU_MAX_ITEMS reached). The numbers of the other items do not change.
+//Only the siblings after it are renumbered, only the rows that changed are redrawn.
+//------------------------------------------------------------------------------------------------------
+int Menu::insertItem(int parent, int rank, const char *label, int action) {
+  if (sharedTree || parent < 0 || parent > lastNode || action < 0 || action > 999) return 0;
+  if ((itemFlags(parent) & MENU_REMOVED) || !treeEditable()) return 0;
+  int item = ownTree->newNode();
+  if (item != 0) {
+    ownTree->ownNodes[item].action = action;
+    if (ownTree->setLabel(item, label) && ownTree->labelAdd(item)) ownTree->link(item, parent, rank);
+    else {                                                          //No memory left : give the node back.
+      ownTree->ownNodes[item].flags = MENU_REMOVED;
+      ownTree->ownNodes[item].previous = ownTree->freeNode;
+      ownTree->freeNode = item;
+      item = 0;
+    }
+  }
+  menuSync(*ownTree);                                                //The tables may have moved.
+  if (item != 0) itemDamage(item);
+  return item;
+}//insertItem-------------------------------------------------------------------------------------------
+
+//removeItem======================================================================================
+//Removes "item" and it's submenu (their numbers will be used again by insertItem()).
+//The current item moves to a sibling of "item" (or to it's parent) if it was in there.
+//The last item at the top of the menu can't be removed. Returns false if nothing was removed.
+//------------------------------------------------------------------------------------------------
+bool Menu::removeItem(int item) {
+  if (sharedTree || item < 1 || item > lastNode || (itemFlags(item) & MENU_REMOVED)) return false;
+  bool hidden = nodes[item].flags & MENU_HIDDEN;
+  if (!hidden && nodes[item].parent == 0 && nodes[0].children == 1) return false;   //Never an empty menu.
+  if (!treeEditable()) return false;
+  menuSync(*ownTree);
+  itemLeave(item);
+  if (!hidden) ownTree->unlink(item);                               //(A hidden item is already out.)
+  ownTree->release(item);
+  menuSync(*ownTree);
+  for (int i = 0; i < MENU_SOURCES; i++) {                          //The lists attached in there are gone too.
+    if (sources[i].source != 0 && (nodes[sources[i].node].flags & MENU_REMOVED)) sources[i].source = 0;
+  }
+  itemDamage(item);
+  return true;
+}//removeItem-------------------------------------------------------------------------------------
+
+//renameItem================================================================
+//Changes the label of "item" to "label" (up to 255 chars, copied).
+//Returns false if it could not be changed.
+//--------------------------------------------------------------------------
+bool Menu::renameItem(int item, const char *label) {
+  if (sharedTree || item < 1 || item > lastNode || (itemFlags(item) & MENU_REMOVED)) return false;
+  if (!treeEditable()) return false;
+  ownTree->labelRemove(item);                                      //Sorted by the old label,
+  bool renamed = ownTree->setLabel(item, label);
+  ownTree->labelAdd(item);                                         //then by the new one.
+  menuSync(*ownTree);
+  itemDamage(item);
+  return renamed;
+}//renameItem---------------------------------------------------------------
+
+//enableItem==========================================================================================
+//Hides "item" and it's submenu (enabled : false), or shows them again, at the same rank (enabled : true).
+//A hidden item is out of it's siblings : it is not shown, not counted and type-ahead skips it.
+//The current item moves to a sibling of "item" (or to it's parent) if it was in there.
+//The last item shown at the top of the menu can't be hidden. Returns false if nothing was done.
+//----------------------------------------------------------------------------------------------------
+bool Menu::enableItem(int item, bool enabled) {
+  if (sharedTree || item < 1 || item > lastNode || (itemFlags(item) & MENU_REMOVED)) return false;
+  bool hidden = nodes[item].flags & MENU_HIDDEN;
+  if (hidden != enabled) return true;                               //Already so.
+  if (!enabled && nodes[item].parent == 0 && nodes[0].children == 1) return false;  //Never an empty menu.
+  if (!treeEditable()) return false;
+  menuSync(*ownTree);
+  node *n = ownTree->ownNodes;
+  if (enabled) {
+    ownTree->hiddenRemove(item);
+    n[item].flags &= ~MENU_HIDDEN;
+    ownTree->link(item, n[item].parent, n[item].rank);               //Back where it was.
+  }
+  else {
+    if (!ownTree->hiddenAdd(item)) return false;                     //(Found from it's parent, see release().)
+    itemLeave(item);
+    ownTree->unlink(item);                                           //It keeps it's rank.
+    n[item].flags |= MENU_HIDDEN;
+  }
+  itemDamage(item);
+  return true;
+}//enableItem-----------------------------------------------------------------------------------------
+
+//itemFlags====================================================================
+//The flags of "node" and of all it's parents (MENU_HIDDEN, MENU_REMOVED) :
+//0 if "node" can be reached in the menu.
+//-----------------------------------------------------------------------------
+int Menu::itemFlags(int node) {
+  int flags = 0;
+  for ( ; node != 0; node = nodes[node].parent) flags |= nodes[node].flags;
+  return flags;
+}//itemFlags-------------------------------------------------------------------
+
+//within=====================================================
+//Returns "true" if "node" is "item" or in it's submenu.
+//-----------------------------------------------------------
+bool Menu::within(int node, int item) {
+  for ( ; node != 0; node = nodes[node].parent) if (node == item) return true;
+  return false;
+}//within----------------------------------------------------
+
+//itemLeave=============================================================================
+//Before "item" is hidden or removed : if the current item is in there,
+//move to the next sibling of "item", or to the previous one, or to it's parent.
+//--------------------------------------------------------------------------------------
+void Menu::itemLeave(int item) {
+  if (!within(currentNode, item)) return;
+  listLeave();
+  if (nodes[item].flags & MENU_HIDDEN) currentNode = nodes[item].parent;  //(Out of it's siblings.)
+  else if ((int) nodes[item].next != item) currentNode = nodes[item].next;
+  else if (nodes[item].rank > 1) currentNode = nodes[item].previous;
+  else currentNode = nodes[item].parent;
+  if (currentNode == 0) currentNode = nodes[0].eldest;
+  needsUpdate = true;
+}//itemLeave-----------------------------------------------------------------------------
+
+//itemDamage=================================================================
+//After a change : the rows that show "item" or a removed node must be redrawn
+//(their numbers may be used again). The other rows are found by lcdDamage().
+//---------------------------------------------------------------------------
+void Menu::itemDamage(int item) {
+  for (int row = 0; row < LCDrows && !list; row++) {
+    long shownItem = shown[row];
+    if (shownItem == item || (shownItem > 0 && shownItem <= lastNode && (nodes[shownItem].flags & MENU_REMOVED))) shown[row] = -1;
+  }
+  needsUpdate = true;
+}//itemDamage----------------------------------------------------------------
+
+//update===========================================
+//The Sketche's keypad returns integers.
+//See Menu::mapKeyInt().
+//See Menu::updateMenu() for more details.
+//-------------------------------------------------
+int Menu::update(int key) {
+	if (key == 0) return 0;
+  int command = keyCommand(key, false);                 //One look in the table.
+  if (command == MENU_CANCEL) {                         //Cancel the last task started.
+    if (taskCount > 0) cancel(tasks[taskCount - 1]);
+    return 0;
+  }
+  MENU_STAT(MenuStopwatch watch(statistics.update));
+	return updateMenu(command);
+}//update------------------------------------------
+
+//update===========================================
+//The Sketche's keypad returns chars.
+// See Menu::mapKeyChar().
+//See Menu::updateMenu() for more details.
+//-------------------------------------------------
+int Menu::update(char key) {
+  if (key == char(0)) return 0;
+  int command = keyCommand((unsigned char) key, true);  //One look in the table.
+  if (command == MENU_CANCEL) {                         //Cancel the last task started.
+    if (taskCount > 0) cancel(tasks[taskCount - 1]);
+    return 0;
+  }
+  MENU_STAT(MenuStopwatch watch(statistics.update));
+  return updateMenu(command);
+}//update------------------------------------------
+
+//update==========================================================================================
+//A batch of keys : they are all applied, in order, and the LCD is signaled only once, at the end
+//(and not at all if we end up where we started).
+//The keys are read as mapped by the last mapKeyInt() or mapKeyChar().
+//Returns the first action met (0 : none) : the keys after it are ignored.
+//Holding UP or DOWN moves faster after a while (see keyRepeat()).
+//------------------------------------------------------------------------------------------------
+int Menu::update(const MenuKey *keys, int count) {
+  MENU_STAT(MenuStopwatch watch(statistics.update));
+  bool wasNeeded = needsUpdate;                 //Where we are before the keys.
+  int node = currentNode;
+  MenuSource *source = list;
+  long entry = listCurrent;
+  int action = 0;
+  for (int i = 0; i < count && action == 0; i++) {
+    int key = keys[i].key;
+    if (key == 0) continue;
+    int move = keysAreChars ? keyCommand((unsigned char) key, true) : keyCommand(key, false);  //The key, as updateMenu() expects it.
+    if (move == MENU_CANCEL) {
+      if (taskCount > 0) cancel(tasks[taskCount - 1]);  //Cancel the last task started.
+      continue;
+    }
+    if (key == repeatKey && keys[i].time - repeatLast <= repeatGap) {   //Still held?
+      repeatLast = keys[i].time;
+    }
+    else {                                                              //A new key.
+      repeatKey = key;
+      repeatStart = repeatLast = keys[i].time;
+    }
+    if (move == 0) continue;
+    int steps = 1;
+    if ((move == MENU_UP || move == MENU_DOWN) && repeatHold > 0 && keys[i].time - repeatStart >= repeatHold) {
+      steps = (repeatJump > 0) ? repeatJump : LCDrows;                   //Held long enough : jump.
+    }
+    for (int step = 0; step < steps && action == 0; step++) {
+      int before = currentNode;
+      long beforeEntry = listCurrent;
+      action = updateMenu(move);
+      if (currentNode == before && listCurrent == beforeEntry) break;    //At the eldest or the youngest.
+    }
+  }
+  needsUpdate = wasNeeded || currentNode != node || list != source || listCurrent != entry || action != 0;
+  return action;
+}//update-----------------------------------------------------------------------------------------
+
+//keyRepeat==================================================================================
+//Key repeat acceleration for update(const MenuKey *keys, int count) :
+//when UP or DOWN is held for "hold" ms (events of the same key less than "gap" ms apart),
+//each event moves "jump" items instead of one (0 : a page, the number of rows of the LCD).
+//A "hold" of 0 turns it off (the default).
+//-------------------------------------------------------------------------------------------
+void Menu::keyRepeat(unsigned long hold, unsigned long gap, int jump) {
+  repeatHold = hold;
+  repeatGap = gap;
+  repeatJump = jump;
+}//keyRepeat---------------------------------------------------------------------------------
+
+//mapKeyCancel=================================================
+//The key that cancels the last task started (see start()).
+//-------------------------------------------------------------
+void Menu::mapKeyCancel(int key) {
+  keyForget(MENU_CANCEL, false);
+  keyBind(key, false, MENU_CANCEL);
+}//mapKeyCancel------------------------------------------------
+
+//mapKeyCancel=================================================
+//Same, for keypads that returns chars.
+//-------------------------------------------------------------
+void Menu::mapKeyCancel(char key) {
+  keyForget(MENU_CANCEL, true);
+  keyBind((unsigned char) key, true, MENU_CANCEL);
+}//mapKeyCancel------------------------------------------------
+
+//start==============================================================================================
+//Runs "task" in the background : a step at a time, each time poll() is called.
+//The menu keeps working meanwhile (redraws, keys), and up to MENU_TASKS tasks can run at once.
+//Returns false if there is no room left for another task.
+//---------------------------------------------------------------------------------------------------
+bool Menu::start(MenuTask *task) {
+  if (taskCount == MENU_TASKS || running(task)) return false;
+  tasks[taskCount++] = task;
+  return true;
+}//start---------------------------------------------------------------------------------------------
+
+//poll==========================================================================
+//Call it in loop() : each running task does one step.
+//A task that is finished is removed, and the LCD is signaled.
+//Returns the number of tasks still running.
+//------------------------------------------------------------------------------
+int Menu::poll() {
+  for (int i = 0; i < taskCount; ) {
+    if (tasks[i]->step()) { i++; continue; }        //Still running.
+    taskRemove(i);                                  //Finished.
+  }
+  return taskCount;
+}//poll-------------------------------------------------------------------------
+
+//cancel================================================================
+//Stops "task" before it is finished : it's cancel() is called.
+//Returns false if "task" was not running.
+//----------------------------------------------------------------------
+bool Menu::cancel(MenuTask *task) {
+  for (int i = 0; i < taskCount; i++) {
+    if (tasks[i] != task) continue;
+    taskRemove(i);
+    task->cancel();
+    return true;
+  }
+  return false;
+}//cancel---------------------------------------------------------------
+
+//running==============================================
+//Returns true if "task" is running.
+//-----------------------------------------------------
+bool Menu::running(MenuTask *task) {
+  for (int i = 0; i < taskCount; i++) if (tasks[i] == task) return true;
+  return false;
+}//running---------------------------------------------
+
+//taskRemove=================================================
+//Takes task "i" out of the running tasks (keeping their order).
+//The task may have used the LCD : redraw the menu.
+//-----------------------------------------------------------
+void Menu::taskRemove(int i) {
+  taskCount--;
+  for ( ; i < taskCount; i++) tasks[i] = tasks[i + 1];
+  updateLcd();
+}//taskRemove------------------------------------------------
+
+#if defined(MENU_STATS)
+//stats=========================================================================
+//The statistics gathered since the menu was built (or since resetStats()).
+//-------------------------------------------------------------------------------
+const MenuStats &Menu::stats() {
+  statistics.nodeBytes = (unsigned long) (lastNode + 1) * sizeof(node);
+  statistics.indexBytes = (unsigned long) lastNode * sizeof(menuIndex);
+  statistics.elapsed = menuMillis() - statsSince;
+  return statistics;
+}//stats------------------------------------------------------------------------
+
+//resetStats=======================================================
+//Starts counting again (the time spent parsing is kept).
+//-----------------------------------------------------------------
+void Menu::resetStats() {
+  unsigned long parseTime = statistics.parseTime;
+  memset(&statistics, 0, sizeof(statistics));
+  statistics.parseTime = parseTime;
+  statsSince = menuMillis();
+}//resetStats------------------------------------------------------
+
+//statsHook=====================================================================
+//"hook" receives the statistics each time exportStats() is called.
+//------------------------------------------------------------------------------
+void Menu::statsHook(void (*hook)(const MenuStats &stats)) {
+  statsExport = hook;
+}//statsHook--------------------------------------------------------------------
+
+//exportStats===================================================================
+//Hands the statistics to the hook (see statsHook()), then starts counting again.
+//------------------------------------------------------------------------------
+void Menu::exportStats() {
+  if (statsExport) statsExport(stats());
+  resetStats();
+}//exportStats------------------------------------------------------------------
+
+//printStats=========================================================
+//Prints the statistics, one "name=value" per line (times in µs).
+//-------------------------------------------------------------------
+#if defined(ARDUINO)
+void Menu::printStats(Print &out) {
+  const MenuStats &s = stats();
+  out.print(F("parseTime=")); out.println(s.parseTime);
+  out.print(F("elapsed="));   out.println(s.elapsed);
+  out.print(F("redraws="));   out.println(s.redraws);
+  out.print(F("strings="));   out.println(s.strings);
+  out.print(F("updates="));   out.println(s.update.count);
+  out.print(F("updateMin=")); out.println(s.update.min);
+  out.print(F("updateMax=")); out.println(s.update.max);
+  out.print(F("updateAvg=")); out.println(s.update.count ? s.update.total / s.update.count : 0);
+  out.print(F("nodeBytes=")); out.println(s.nodeBytes);
+  out.print(F("indexBytes=")); out.println(s.indexBytes);
+}
+#else
+void Menu::printStats(FILE *out) {
+  const MenuStats &s = stats();
+  fprintf(out, "parseTime=%lu\nelapsed=%lu\nredraws=%lu\nstrings=%lu\n", s.parseTime, s.elapsed, s.redraws, s.strings);
+  fprintf(out, "updates=%lu\nupdateMin=%lu\nupdateMax=%lu\nupdateAvg=%lu\n", s.update.count, s.update.min, s.update.max,
+          s.update.count ? s.update.total / s.update.count : 0);
+  fprintf(out, "nodeBytes=%lu\nindexBytes=%lu\n", s.nodeBytes, s.indexBytes);
+}
+#endif
+//printStats---------------------------------------------------------
+#endif
@@ -1,121 +1,781 @@
-/*
-* Menu.h
-* Author : Jacques Bellavance
-* Date : Septembet 12, 2016
-* Version : 1.00
-*/
-
-/*
-This library is free software; you can redistribute it and/or
-modify it under the terms of the GNU Lesser General Public
-License as published by the Free Software Foundation; either
-version 2.1 of the License, or (at your option) any later version.
-
-This library is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-Lesser General Public License for more details.
-
-You should have received a copy of the GNU Lesser General
-Public License along with this library; if not, write to the
-Free Software Foundation, Inc., 59 Temple Place, Suite 330,
-Boston, MA  02111-1307  USA
-*/
-
-/*
- * Menu.h
- * Allows the use of menus in sketches.
- * The menu is declared in a String. 
- * (See Menu::parse() in Menu.cpp for instructions on how a menu is built) 
- * The menu is parsed, allowing easy navigation thru the menu
- */
- 
-#ifndef Menu_h
-#define Menu_h
-
-class Menu {
-  public: //===================================================================================================
-  //Constructor 
-    Menu(String items);                                           //items : the String containing the menu
-
-  //Methods
-    //To be used in the setup part of the sketch
-		void defineLcd(int columns, int rows);                        //The number of columns and rows of the LCD
-		void mapKeyChar(char UP, char DOWN, char LEFT, char RIGHT);   //For keypads that returns chars
-		void mapKeyInt(int UP, int DOWN, int LEFT, int RIGHT);        //For keypads that returns integers
-
-    //Display the menu on the LCD tools 
-		String lcdLine(int line);          														//Returns the label to be displayed on the LCD's "line"
-		bool LcdNeedsUpdate();                                        //Returns "true" if the LCD needs to be updated
-		void LcdUpdated();                                            //Says that the current menu was udated on the LCD
-		void updateLcd();                                             //Says that the LCD will need to be updated
-
-    //A key was pressed, update the menu
-		int update(int key);	                                        //Update the menu according to "mapKeyInt"
-		int update(char key);                                         //Update the menu according to "mapKeyChar"
-
-    //Provide some informations to the sketch 
-	  String getCurrentLabel();                                     //Returns the label of the current item
-		int getCurrentItem();                                         //Returns the number of the current menu item (currentNode)
-    int getAction();            	                                //Returns the action associated to the current item 
-		int itemNumber(String find);																	//Returns the number of the first menu item with label "find"
-		void selectItem(int number);																	//Makes item "number" the current item
-
-    //Let the Sketch advise us that
-		void done();                                                  //The action is handled, return to the menu
-    void reset();                                                 //Sets currentNode to 1
-
-  private: //====================================================================================================
-    //Default values for the size of the LCD
-    int LCDcol = 16;
-    int LCDrows = 2;
-
-    //The full menu is contained in "MYitems"
-    //A node is associated to each item in the menu.
-    //The nodes are placed in the table "nodes[]"
-    //The menu is then parsed to setup nodes
-    String MYitems;     //The full menu
-    struct node {       //For each item :
-      int starts = 0;     //the index of the start of the label
-      int ends = 0;       //the index of the end of the label
-      byte parent = 0;    //the node number of the parent of this item
-      byte eldest = 1;    //the node number of the eldest of this item
-      int action = 0;     //the action associated to this item
-    };
-	  node *nodes;              //The table that holds the nodes (using calloc() to use only the needed memory)
-    void menuParse();         //Actual parsing of "MYitems" and setup of "nodes[]"
-		int updateMenu(int key);	//Update the menu
-		bool needsUpdate;         //The flag to signal that the LCD needs an update or not
-
-    //Labels of the menu or submenu to be displayed on the LCD
-    String label(int node); //Returns the label of "node"
-
-    //Moving around the menus
-    int currentNode = 1;            //The index of the current node
-    int lastNode = 1;               //The index of the last node
-    int parent(int node);           //The parent of "node"
-    int eldest(int node);           //The eldest child of "node"
-    int previousSibling(int node);  //The previous sibling of "node"
-    int nextSibling(int node);      //The next sibling of "node"
-		int siblingsCount(int node);    //The number of siblings of "node"
-    int rank(int node);             //The rank of "node" amongst it's siblings
-    
-
-  //SWITCHES  
-		int UP = 1;         //The values that updateMenu(int key) is expecting
-		int DOWN = 2;
-		int LEFT = 3;
-		int RIGHT = 4;
-		
-    int MYUP;           //The values that will be provided by the sketch via update(int key)
-    int MYDOWN;
-    int MYLEFT;
-    int MYRIGHT;
-
-		char MYCHARUP;      //The values that will be provided by the sketch via update(char key)
-		char MYCHARDOWN;
-		char MYCHARLEFT;
-		char MYCHARRIGHT;
-};
-
-#endif
+/*
+* Menu.h
+* Author : Jacques Bellavance
+* Date : Septembet 12, 2016
+* Version : 1.00
+*/
+
+/*
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General
+Public License along with this library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+Boston, MA  02111-1307  USA
+*/
+
+/*
+ * Menu.h
+ * Allows the use of menus in sketches.
+ * The menu is declared in a String. 
+ * (See Menu::parse() in Menu.cpp for instructions on how a menu is built) 
+ * The menu is parsed, allowing easy navigation thru the menu
+ */
+ 
+#ifndef Menu_h
+#define Menu_h
+
+//Outside of the Arduino IDE (on a host computer), the library is built without <Arduino.h> :
+//the String and flash (PROGMEM) parts are left out, everything else works the same.
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+typedef uint8_t byte;
+#endif
+
+//MENU_INDEX_BITS : the width of the node numbers (8, 16 or 32 bits).
+//8 bits keep the nodes small, but limit the menu to 255 items (the default on AVR boards).
+//16 bits allow 65535 items (the default elsewhere), 32 bits allow more
+//(one less than an int can count, so that the nodes, root included, still fit an int).
+//To change it, define MENU_INDEX_BITS in the build flags (e.g. -DMENU_INDEX_BITS=32).
+//The depth of the menu is not limited.
+#ifndef MENU_INDEX_BITS
+#if defined(__AVR__)
+#define MENU_INDEX_BITS 8
+#else
+#define MENU_INDEX_BITS 16
+#endif
+#endif
+
+#if MENU_INDEX_BITS == 8
+typedef uint8_t menuIndex;
+#define MENU_MAX_ITEMS 255L
+#elif MENU_INDEX_BITS == 16
+typedef uint16_t menuIndex;
+#define MENU_MAX_ITEMS 65535L
+#elif MENU_INDEX_BITS == 32
+typedef uint32_t menuIndex;
+#define MENU_MAX_ITEMS 2147483646L
+#else
+#error "MENU_INDEX_BITS must be 8, 16 or 32"
+#endif
+
+//MENU_TYPEAHEAD : how many keys typeAhead() remembers.
+#ifndef MENU_TYPEAHEAD
+#define MENU_TYPEAHEAD 16
+#endif
+
+//The labels are found by their offset in the menu : 16 bits with 8 bits node numbers, 32 bits otherwise.
+#if MENU_INDEX_BITS == 8
+typedef uint16_t menuOffset;
+#else
+typedef uint32_t menuOffset;
+#endif
+//The longest menu (labels added included) : as far as an offset, and an int, can go.
+#define MENU_MAX_LENGTH ((unsigned long) (menuOffset) -1 < ((unsigned int) -1 >> 1) ? \
+                         (long) (menuOffset) -1 : (long) ((unsigned int) -1 >> 1))
+
+//With 8 bits node numbers, the nodes are packed everywhere as they are on AVR,
+//so that a menu image made on a host computer fits an AVR board (see MenuImage).
+#if MENU_INDEX_BITS == 8
+#define MENU_PACKED __attribute__((packed))
+#else
+#define MENU_PACKED
+#endif
+
+//A node is associated to each item in the menu.
+//Bytes per node : 12 with 8 bits node numbers (AVR), 20 with 16 bits, 32 with 32 bits.
+#define MENU_HIDDEN 1     //flags : the item is hidden (see Menu::enableItem())
+#define MENU_REMOVED 2    //flags : the node is free (see Menu::removeItem())
+struct MENU_PACKED MenuNode {  //For each item :
+  menuOffset start = 0;   //the index of the start of the label
+  menuIndex parent = 0;   //the node number of the parent of this item
+  menuIndex eldest = 1;   //the node number of the eldest of this item
+  menuIndex previous = 0; //the node number of the previous sibling (the youngest if it is the eldest)
+  menuIndex next = 0;     //the node number of the next sibling (itself if it is the youngest)
+  menuIndex rank = 1;     //the rank of this item amongst it's siblings
+  menuIndex children = 0; //the number of children of this item
+  uint16_t action = 0;    //the action associated to this item (0 to 999)
+  uint8_t length = 0;     //the length of the label (up to 255 chars)
+  uint8_t flags = 0;      //MENU_HIDDEN, MENU_REMOVED
+};
+
+//MenuImage===================================================================================
+//A precompiled menu : parsed once (on a host computer, see extras/menuc), then used where it is
+//(in flash, in a buffer read from an EEPROM or an SD card, in a mmap()'ed file).
+//This header is followed by the nodes (nodes + 1 MenuNode), the node numbers sorted by label
+//(labels menuIndex) and the menu (length chars + '\0').
+//An image only fits the MENU_INDEX_BITS it was made with (checked by Menu::imageCheck()).
+//In RAM, it must be aligned on 4 bytes.
+//--------------------------------------------------------------------------------------------
+#define MENU_IMAGE_VERSION 3
+struct MenuImage {
+  char magic[4];          //"MENU"
+  uint8_t version;        //MENU_IMAGE_VERSION
+  uint8_t indexBits;      //MENU_INDEX_BITS
+  uint8_t nodeSize;       //sizeof(MenuNode)
+  uint8_t spare;          //0
+  uint16_t order;         //0x0102, to check the byte order
+  uint16_t checksum;      //Fletcher-16 of everything after the header
+  uint32_t nodes;         //The number of nodes (the highest item number)
+  uint32_t labels;        //The number of items (the removed ones are not sorted)
+  uint32_t length;        //The length of the menu
+};//MenuImage---------------------------------------------------------------------------------
+
+//MenuMemory==================================================================================
+//A block of memory from malloc(), calloc() or realloc(), owned by a Menu :
+//freed with the Menu, handed over when the Menu is moved, never copied.
+//It reads like a pointer. Assigning a pointer stores it as is (e.g. the result of realloc()).
+//--------------------------------------------------------------------------------------------
+template <typename T> class MenuMemory {
+  public:
+    MenuMemory() : block(0) {}
+    ~MenuMemory() { free(block); }
+    MenuMemory(const MenuMemory &) = delete;
+    MenuMemory &operator=(const MenuMemory &) = delete;
+    MenuMemory(MenuMemory &&other) : block(other.block) { other.block = 0; }
+    MenuMemory &operator=(MenuMemory &&other) {
+      if (this != &other) { free(block); block = other.block; other.block = 0; }
+      return *this;
+    }
+    MenuMemory &operator=(T *pointer) { block = pointer; return *this; }
+    operator T *() const { return block; }
+  private:
+    T *block;
+};//MenuMemory--------------------------------------------------------------------------------
+
+//MenuObject==================================================================================
+//An object from new, owned by a Menu (it's MenuTree) : deleted with the Menu, handed over when
+//the Menu is moved, never copied. It reads like a pointer (0 : none).
+//--------------------------------------------------------------------------------------------
+template <typename T> class MenuObject {
+  public:
+    MenuObject(T *pointer = 0) : object(pointer) {}
+    ~MenuObject() { delete object; }
+    MenuObject(const MenuObject &) = delete;
+    MenuObject &operator=(const MenuObject &) = delete;
+    MenuObject(MenuObject &&other) : object(other.object) { other.object = 0; }
+    MenuObject &operator=(MenuObject &&other) {
+      if (this != &other) { delete object; object = other.object; other.object = 0; }
+      return *this;
+    }
+    T *operator->() const { return object; }
+    operator T *() const { return object; }
+  private:
+    T *object;
+};//MenuObject--------------------------------------------------------------------------------
+
+//MenuError===================================================================================
+//What is wrong with a menu, and where (see MenuTree::error()).
+//A MENU_TABLE is checked by the compiler, the other menus by the parser, as it goes :
+//the items before the error are kept.
+//--------------------------------------------------------------------------------------------
+namespace MenuTable {
+  enum Error {          //What can be wrong with a menu :
+    NONE,                 //Nothing.
+    NO_ITEMS,             //The menu is empty.
+    NO_DASH,              //The menu does not start with a dash.
+    MISSING_COLON,        //An item has no ":" token.
+    BAD_ACTION,           //An action is not exactly 3 digits.
+    LEVEL_JUMP,           //An item is more than one level deeper than the item before it.
+    TOO_MANY_ITEMS,       //More than MENU_MAX_ITEMS items.
+    NO_MEMORY,            //The nodes (or the label index, or the rows of the LCD) do not fit in memory.
+    BAD_IMAGE,            //The image is not valid (see MenuTree::imageCheck()).
+    LONG_LABEL,           //A label is longer than 255 chars.
+    LONG_MENU             //The menu is longer than MENU_MAX_LENGTH chars (65535 with 8 bits node numbers).
+  };
+}
+struct MenuError {
+  int code = MenuTable::NONE;   //What is wrong (see MenuTable::Error)
+  long item = 0;                //The number the item would have had
+  long line = 0;                //The line of the menu (1 : the first), for a menu read from a file
+  long offset = 0;              //The character of the menu (0 : the first)
+};
+
+#if __cplusplus >= 201402L
+/*
+ * MenuTable (C++14 and up)
+ * A menu parsed by the compiler : the nodes and the labels sorted are built at compile time, in a constant table.
+ * Nothing is parsed or sorted at boot, and the Menu reads the table where it is : the menu takes nothing
+ * from the heap (the rows of the LCD do, see Menu::defineLcd()), until it is changed (see Menu::insertItem()).
+ * A malformed menu does not compile (see MENU_TABLE below).
+ *   MENU_TABLE(menuTable,
+ *     "-READ:000"
+ *     "--SENSORS:000"
+ *     ...
+ *     "-LONG ROUTINE:108");
+ *   Menu menu(menuTable);
+ * (On AVR, constant data still lives in RAM, but it is neither parsed nor allocated at boot.)
+ */
+namespace MenuTable {
+  //length=========================================
+  constexpr int length(const char *text) {
+    int len = 0;
+    while (text[len] != '\0') len++;
+    return len;
+  }//length----------------------------------------
+
+  //count===================================================
+  //The number of items in the menu (count the colons).
+  //--------------------------------------------------------
+  constexpr int count(const char *text) {
+    int colons = 0;
+    for (int i = 0; text[i] != '\0'; i++) if (text[i] == ':') colons++;
+    return colons;
+  }//count--------------------------------------------------
+
+  //check==============================================================
+  //Returns the first thing that is wrong with the menu (NONE if it is ok).
+  //-------------------------------------------------------------------
+  constexpr int check(const char *text) {
+    int len = length(text);
+    if (len == 0) return NO_ITEMS;
+    if (text[0] != '-') return NO_DASH;
+    if (count(text) > MENU_MAX_ITEMS) return TOO_MANY_ITEMS;
+    if (len > MENU_MAX_LENGTH) return LONG_MENU;
+    int pos = 0;
+    int level = 0;
+    while (pos < len) {
+      int dashes = 0;
+      while (pos < len && text[pos] == '-') { pos++; dashes++; }      //The level of the item.
+      if (dashes > level + 1) return LEVEL_JUMP;
+      level = dashes;
+      int start = pos;
+      while (pos < len && text[pos] != ':') pos++;                    //Forward to the ":" token.
+      if (pos == len) return MISSING_COLON;
+      if (pos - start > 255) return LONG_LABEL;
+      for (int i = 1; i <= 3; i++) {                                  //Exactly 3 digits.
+        if (pos + i >= len || text[pos + i] < '0' || text[pos + i] > '9') return BAD_ACTION;
+      }
+      pos += 4;
+      if (pos < len && text[pos] != '-') return BAD_ACTION;
+    }
+    return NONE;
+  }//check------------------------------------------------------------
+
+  //labelOrder=================================================================
+  //The order of the labels of nodes "a" and "b", as MenuTree::labelOrder() :
+  //ignoring case, then by node number. (<0 : "a" first, >0 : "b" first)
+  //----------------------------------------------------------------------------
+  constexpr int labelOrder(const char *text, const MenuNode *nodes, int a, int b) {
+    int posA = nodes[a].start, posB = nodes[b].start;
+    int endA = posA + nodes[a].length, endB = posB + nodes[b].length;
+    while (posA < endA && posB < endB) {
+      int charA = text[posA++], charB = text[posB++];
+      if (charA >= 'a' && charA <= 'z') charA -= 'a' - 'A';
+      if (charB >= 'a' && charB <= 'z') charB -= 'a' - 'A';
+      if (charA != charB) return charA - charB;
+    }
+    if (posA < endA) return 1;
+    if (posB < endB) return -1;
+    return a - b;
+  }//labelOrder------------------------------------------------------------------
+
+  //Table===================================================================
+  //The nodes of a menu of N items, and their labels sorted, built by the compiler.
+  //Same parsing as Menu::menuParse(), same order as MenuTree::labelIndex().
+  //------------------------------------------------------------------------
+  template <int N> struct Table {
+    MenuNode nodes[N + 1];      //The nodes (node 0 is the root)
+    menuIndex sorted[N > 0 ? N : 1];  //The node numbers sorted by label
+    const char *text;           //The menu
+    int length;                 //The length of the menu
+    int lastNode;               //The number of items in the menu
+
+    constexpr Table(const char *items) : nodes{}, sorted{}, text(items), length(MenuTable::length(items)), lastNode(0) {
+      int parentNode = 0;
+      int older = 0;
+      int pos = 1;
+      int item = 1;
+      int curLevel = 1;
+      int nextLevel = 1;
+      while (pos < length && item <= N) {
+        nodes[item].start = pos;
+        while (pos < length && text[pos] != ':') pos++;
+        nodes[item].length = pos - nodes[item].start;
+        for (int i = pos + 1; i < pos + 4 && i < length; i++) nodes[item].action = nodes[item].action * 10 + (text[i] - '0');
+        nodes[item].parent = parentNode;
+        nodes[item].next = item;
+        if (older == 0) nodes[item].previous = item;
+        else {
+          nodes[item].previous = older;
+          nodes[older].next = item;
+          nodes[item].rank = nodes[older].rank + 1;
+          nodes[nodes[parentNode].eldest].previous = item;
+        }
+        nodes[parentNode].children++;
+        pos += 4;
+        nextLevel = 0;
+        while (pos < length && text[pos] == '-') { pos++; nextLevel++; }
+        if (nextLevel > curLevel) {
+          nodes[item].eldest = item + 1;
+          parentNode = item;
+          older = 0;
+          nextLevel = curLevel + 1;
+        }
+        else {
+          older = item;
+          for ( ; curLevel > nextLevel && parentNode != 0; curLevel--) {
+            older = parentNode;
+            parentNode = nodes[parentNode].parent;
+          }
+        }
+        item++; curLevel = nextLevel;
+      }
+      lastNode = item - 1;
+      sortLabels();
+    }
+
+    //A merge sort, runs of 1, 2, 4... items : the compiler does N log N comparisons.
+    constexpr void sortLabels() {
+      menuIndex merged[N > 0 ? N : 1] = {};
+      for (int i = 0; i < lastNode; i++) sorted[i] = i + 1;
+      for (int run = 1; run < lastNode; run *= 2) {
+        for (int first = 0; first < lastNode; first += 2 * run) {
+          int middle = first + run < lastNode ? first + run : lastNode;
+          int end = first + 2 * run < lastNode ? first + 2 * run : lastNode;
+          int a = first, b = middle, to = first;
+          while (a < middle && b < end) merged[to++] = labelOrder(text, nodes, sorted[a], sorted[b]) <= 0 ? sorted[a++] : sorted[b++];
+          while (a < middle) merged[to++] = sorted[a++];
+          while (b < end) merged[to++] = sorted[b++];
+        }
+        for (int i = 0; i < lastNode; i++) sorted[i] = merged[i];
+      }
+    }
+  };//Table----------------------------------------------------------------
+}
+
+//MENU_TABLE===============================================================================
+//Declares "name", the constant table of the menu "items" (a string literal).
+//The compiler refuses a malformed menu.
+//-----------------------------------------------------------------------------------------
+#define MENU_TABLE(name, items) \
+  static_assert(MenuTable::check(items) != MenuTable::NO_ITEMS, "Menu: the menu is empty"); \
+  static_assert(MenuTable::check(items) != MenuTable::NO_DASH, "Menu: the menu must start with a dash"); \
+  static_assert(MenuTable::check(items) != MenuTable::MISSING_COLON, "Menu: an item has no ':'"); \
+  static_assert(MenuTable::check(items) != MenuTable::BAD_ACTION, "Menu: an action is not exactly 3 digits"); \
+  static_assert(MenuTable::check(items) != MenuTable::LEVEL_JUMP, "Menu: an item is more than one level deeper than the one before"); \
+  static_assert(MenuTable::check(items) != MenuTable::TOO_MANY_ITEMS, "Menu: more items than MENU_INDEX_BITS allows"); \
+  static_assert(MenuTable::check(items) != MenuTable::LONG_LABEL, "Menu: a label is longer than 255 chars"); \
+  static_assert(MenuTable::check(items) != MenuTable::LONG_MENU, "Menu: the menu is longer than MENU_INDEX_BITS allows"); \
+  constexpr MenuTable::Table<MenuTable::count(items)> name(items)
+#endif
+
+//MENU_SOURCES : how many lists (MenuSource) can be attached to a Menu.
+#ifndef MENU_SOURCES
+#define MENU_SOURCES 4
+#endif
+
+/*
+ * MenuSource
+ * A list supplied by the sketch, one entry at a time : files on an SD card, sensors, logs...
+ * It is attached to a node of the menu (see Menu::attachSource()), and its entries become the children of that node.
+ * The Menu asks only for the entries it displays and keeps a few copies of their labels :
+ * its memory does not depend on the length of the list.
+ */
+class MenuSource {
+  public:
+    virtual long count() = 0;                                   //The number of entries in the list
+    virtual int label(long index, char *buffer, int size) = 0;  //Copy the label of entry "index" (0 to count()-1)
+                                                                //in "buffer" (at most "size" chars, no '\0' needed),
+                                                                //return it's length
+    virtual int action(long /*index*/) { return 0; }            //The action of entry "index" (0 : none)
+};
+
+//MENU_TASKS : how many tasks (MenuTask) can run at once.
+#ifndef MENU_TASKS
+#define MENU_TASKS 4
+#endif
+
+/*
+ * MenuTask
+ * An action that takes a while, split in small steps : it runs in the background (see Menu::start()),
+ * one step each time Menu::poll() is called, so that the menu stays responsive.
+ * Keep the steps short : read the time (millis()) instead of using delay(), remember where you are in members.
+ */
+class MenuTask {
+  public:
+    virtual bool step() = 0;        //Do a little of the work. Return false when it is finished.
+    virtual void cancel() {}        //The task is stopped before it is finished : clean up.
+};
+
+//MENU_STATS : define it in the build flags (-DMENU_STATS) to gather statistics on what the menu costs.
+//Without it, nothing is counted and nothing is timed : no code, no memory.
+#if defined(MENU_STATS)
+#if !defined(ARDUINO)
+#include <stdio.h>
+#endif
+struct MenuTiming {             //Timings, in µs :
+  unsigned long count;            //how many,
+  unsigned long min;              //the shortest,
+  unsigned long max;              //the longest,
+  unsigned long total;            //all of them (average = total / count).
+};
+struct MenuStats {
+  unsigned long parseTime;      //Time spent parsing the menu (µs)
+  unsigned long elapsed;        //Time spent counting (ms)
+  unsigned long redraws;        //LCD redraws (LcdUpdated() when LcdNeedsUpdate())
+  unsigned long strings;        //String temporaries built (lcdLine(), getCurrentLabel())
+  MenuTiming update;            //update() (keys only)
+  unsigned long nodeBytes;      //Size of the node table
+  unsigned long indexBytes;     //Size of the label index
+};
+#endif
+
+//MENU_KEYS : how many keys can be bound to commands (see Menu::mapKey()).
+#ifndef MENU_KEYS
+#define MENU_KEYS 16
+#endif
+
+//MenuCommand : what a key does (see Menu::mapKey()).
+enum MenuCommand {
+  MENU_NONE = 0,      //nothing (unbinds the key)
+  MENU_UP,            //the previous item
+  MENU_DOWN,          //the next item
+  MENU_LEFT,          //back to the parent
+  MENU_RIGHT,         //into the submenu, or the action of the item
+  MENU_PAGE_UP,       //a page (the rows of the LCD) up
+  MENU_PAGE_DOWN,     //a page down
+  MENU_HOME,          //the eldest of the siblings
+  MENU_END,           //the youngest of the siblings
+  MENU_TOP,           //the first item at the top of the menu (out of every submenu)
+  MENU_CANCEL         //cancels the last task started (see MenuTask)
+};
+
+//MenuKey : a key event, for Menu::update(const MenuKey *keys, int count).
+struct MenuKey {
+  int key;                //The key (as given to update(int key) or update(char key))
+  unsigned long time;     //When it happened (ms, e.g. millis())
+};
+
+//MenuTree====================================================================================
+//The parsed menu : the labels, the nodes and the labels sorted. Built once, then only read.
+//Any number of Menus can share one MenuTree (one per operator, per console, per thread) :
+//each Menu then only holds where it is in the menu, it's keys and what it's LCD shows.
+//Being only read, a MenuTree needs no lock. It must live as long as the Menus that share it.
+//--------------------------------------------------------------------------------------------
+class MenuTree {
+  public:
+#if defined(ARDUINO)
+    MenuTree(String items);                                       //items : the String containing the menu (copied)
+    MenuTree(const __FlashStringHelper *items);                   //items : the menu in flash (PROGMEM), read where it is
+#endif
+    MenuTree(const char *items);                                  //items : the menu, read where it is (not copied)
+    MenuTree(const char *items, long length);                     //Same, "length" chars of it (no '\0' needed : a file mmap()'ed)
+    MenuTree(const MenuImage *image, long size, bool inFlash = false); //image : a precompiled menu of "size" bytes, used where it is (inFlash : in PROGMEM on AVR)
+#if __cplusplus >= 201402L
+    template <int N> MenuTree(const MenuTable::Table<N> &table) { //table : a menu parsed at compile time (see MENU_TABLE)
+      labelCount = table.lastNode;
+      treeInit(table.text, table.length, table.nodes, table.lastNode, false, table.sorted);
+    }
+#endif
+    MenuTree(const MenuTree &) = delete;                          //A MenuTree owns it's tables : it is not copied,
+    MenuTree &operator=(const MenuTree &) = delete;
+    MenuTree(MenuTree &&) = default;                              //but it can be moved
+    MenuTree &operator=(MenuTree &&) = default;
+
+    int items() const { return lastNode; }                        //The highest item number
+    const MenuError &error() const { return parseError; }         //What was wrong with the menu (code NONE : nothing)
+
+    //Precompiled menus (see MenuImage)
+    long image(void *buffer, long size) const;                    //Writes the image of the menu in "buffer", returns it's size (written only if it fits)
+    static long imageCheck(const MenuImage *image, long size, bool inFlash = false); //Returns the size of "image" if it is valid (0 : not valid)
+
+  private:
+    friend class Menu;
+    MenuTree() {}                                   //No menu yet
+    explicit MenuTree(MenuNode *table);             //The menu of noMemory(), using "table" (2 nodes)
+    static const MenuTree &noMemory();              //A one item menu that says so, for a Menu without a tree
+
+    //The full menu is found at "MYtext" (in "ownText" if it was given as a String)
+    MenuMemory<char> ownText;     //The copy of the menu, when it was given as a String
+    const char *MYtext = 0;       //Where the menu is
+    bool MYflash = false;         //true if "MYtext" is in flash (PROGMEM)
+    int MYlength = 0;             //The length of the menu
+    typedef MenuNode node;        //For each item, a node (see MenuNode above)
+    const node *nodes = 0;        //The table that holds the nodes
+    MenuMemory<node> ownNodes;    //The same, when the tree parsed it (using calloc() to use only the needed memory)
+    const menuIndex *byLabel = 0;     //The node numbers, sorted by label (see labelIndex())
+    MenuMemory<menuIndex> ownLabels;  //The same, when the tree sorted them
+    int labelCount = 0;           //The number of entries in "byLabel[]"
+    int lastNode = 0;             //The highest item number
+    MenuError parseError;         //What was wrong with the menu
+#if defined(MENU_STATS)
+    unsigned long parseTime = 0;  //The time it took to build the tree (µs)
+#endif
+    void treeInit(const char *text, bool inFlash, long length = -1);  //Common part of the constructors (-1 : up to the '\0')
+    void treeInit(const char *text, int length, const MenuNode *table, int last,  //Same, for an already parsed menu
+                  bool inFlash = false, const menuIndex *sorted = 0);         //(and maybe already sorted)
+    char itemChar(int pos) const;                   //The character at "pos" in the menu
+    int itemFind(int pos, int end, char c) const;   //The first "c" in the menu, from "pos" to "end" ("end" : none)
+    void menuParse();                               //Actual parsing of the menu and setup of "ownNodes[]"
+    void menuError(int code, int item, long line, int pos);  //Records what is wrong, and where
+    void labelIndex();                              //Sorts "ownLabels[]"
+    void labelSift(int root, int count);            //Heap sort, one step
+    int labelOrder(int a, int b) const;             //The order of two nodes in "byLabel[]"
+    static void imageRead(void *to, const MenuImage *image, long pos, long size, bool inFlash); //Reading an image (see MenuImage)
+    static uint16_t imageSum(const MenuImage *image, long pos, long end, bool inFlash);
+    static long imageSize(const MenuImage &header);
+    static bool imageNodes(const MenuImage *image, const MenuImage &header, bool inFlash);
+    static MenuNode imageNode(const MenuImage *image, uint32_t item, bool inFlash);
+
+    //Changing the menu (see Menu::insertItem()) : "ownNodes[]", "ownLabels[]" and "ownExtra" grow as needed
+    int nodeCapacity = 0;                 //The nodes allocated in "ownNodes[]" (0 : "nodes[]" is not owned)
+    int labelCapacity = 0;                //The entries allocated in "ownLabels[]" (0 : "byLabel[]" is not owned)
+    MenuMemory<char> ownExtra;            //The labels added or changed, found after the menu (from MYlength)
+    int extraLength = 0;
+    int extraCapacity = 0;
+    int freeNode = 0;                     //The removed nodes, linked by "previous" (0 : none)
+    MenuMemory<menuIndex> ownHidden;      //The hidden items (out of their siblings), sorted by parent, then by number
+    int hiddenCount = 0;
+    int hiddenCapacity = 0;
+    bool editable();                      //Owns "nodes[]" and "byLabel[]", so that they can be changed
+    int newNode();                        //A free node (0 : none left)
+    bool setLabel(int item, const char *label);  //Stores the label of "item"
+    void link(int item, int parent, int rank);   //Puts "item" amongst the children of "parent", at "rank"
+    void unlink(int item);                       //Takes "item" out of it's siblings
+    void ranks(int from);                        //Renumbers the siblings after "from"
+    void release(int item);                      //Frees "item" and it's submenu
+    void releaseLinked(int item);                //Frees "item" and the submenu linked under it
+    bool labelAdd(int item);                     //Puts "item" in "byLabel[]"
+    void labelRemove(int item);                  //Takes it out
+    int hiddenFind(int parent, int item) const;  //Where "item" (a child of "parent") is, or goes, in "ownHidden[]"
+    bool hiddenAdd(int item);                    //Puts "item" in "ownHidden[]"
+    void hiddenRemove(int item);                 //Takes it out
+};//MenuTree----------------------------------------------------------------------------------
+
+class Menu {
+  public: //===================================================================================================
+  //Constructor 
+#if defined(ARDUINO)
+    Menu(String items);                                           //items : the String containing the menu (copied)
+    Menu(const __FlashStringHelper *items);                       //items : the menu in flash (PROGMEM), read where it is
+#endif
+    Menu(const char *items);                                      //items : the menu, read where it is (not copied)
+    Menu(const char *items, long length);                         //Same, "length" chars of it (no '\0' needed : a file mmap()'ed)
+    Menu(const MenuImage *image, long size, bool inFlash = false); //image : a precompiled menu of "size" bytes, used where it is (inFlash : in PROGMEM on AVR)
+#if __cplusplus >= 201402L
+    template <int N> Menu(const MenuTable::Table<N> &table) {     //table : a menu parsed at compile time (see MENU_TABLE), read where it is
+      menuInit(table.text, table.length, table.nodes, table.lastNode, table.sorted);
+    }
+#endif
+    Menu(const MenuTree &tree);                                   //tree : a menu shared with other Menus (not copied)
+    Menu(MenuTree &&tree);                                        //tree : a menu of it's own
+    Menu(const Menu &) = delete;                                  //A Menu owns it's tables : it is not copied,
+    Menu &operator=(const Menu &) = delete;
+    Menu(Menu &&) = default;                                      //but it can be moved (the tables follow it)
+    Menu &operator=(Menu &&) = default;
+
+  //Methods
+    //To be used in the setup part of the sketch
+		bool defineLcd(int columns, int rows);                        //The number of columns and rows of the LCD (false : none, or no memory for it)
+		void mapKeyChar(char UP, char DOWN, char LEFT, char RIGHT);   //For keypads that returns chars
+		void mapKeyInt(int UP, int DOWN, int LEFT, int RIGHT);        //For keypads that returns integers
+		bool mapKey(int key, MenuCommand command);                    //Binds one more key to "command" (MENU_NONE : unbinds it)
+		bool mapKey(char key, MenuCommand command);                   //Same, for keys that are chars
+
+    //Display the menu on the LCD tools 
+#if defined(ARDUINO)
+		String lcdLine(int line);          														//Returns the label to be displayed on the LCD's "line"
+#endif
+		void lcdLine(int line, char *buffer);                         //Writes the LCD's "line" in "buffer" (LCDcol chars + '\0', no allocation)
+		bool LcdNeedsUpdate();                                        //Returns "true" if the LCD needs to be updated
+		void LcdUpdated();                                            //Says that the current menu was udated on the LCD
+		void updateLcd();                                             //Says that the LCD will need to be updated
+		unsigned long lcdDamage();                                    //Returns the rows changed since LcdUpdated() (bit "row" set)
+		bool lcdDamage(int row, int &first, int &last);               //Returns "true" if "row" changed, and which columns changed
+
+    //A key was pressed, update the menu
+		int update(int key);	                                        //Update the menu according to "mapKeyInt"
+		int update(char key);                                         //Update the menu according to "mapKeyChar"
+		int update(const MenuKey *keys, int count);                   //Update the menu with a batch of keys (redraw once)
+		void keyRepeat(unsigned long hold, unsigned long gap, int jump);  //Jump "jump" items when a key is held for "hold" ms
+
+    //Actions that run in the background (see MenuTask)
+		bool start(MenuTask *task);                                   //Starts "task"
+		int poll();                                                   //Runs one step of each task (call it in loop())
+		bool cancel(MenuTask *task);                                  //Stops "task"
+		bool running(MenuTask *task);                                 //Returns "true" if "task" is running
+		void mapKeyCancel(int key);                                   //The key that cancels the last task started
+		void mapKeyCancel(char key);                                  //Same, for keypads that returns chars
+
+#if defined(MENU_STATS)
+    //What the menu costs (see MenuStats)
+		const MenuStats &stats();                                     //Returns the statistics
+		void resetStats();                                            //Starts counting again
+		void statsHook(void (*hook)(const MenuStats &stats));         //The function that receives the statistics
+		void exportStats();                                           //Hands the statistics to the hook, and starts counting again
+#if defined(ARDUINO)
+		void printStats(Print &out);                                  //Prints the statistics (e.g. on Serial)
+#else
+		void printStats(FILE *out);                                   //Prints the statistics
+#endif
+#endif
+
+    //Provide some informations to the sketch 
+#if defined(ARDUINO)
+	  String getCurrentLabel();                                     //Returns the label of the current item
+#endif
+	  const char *getCurrentLabel(int &length);                     //Returns the label of the current item, without a copy (not '\0' terminated)
+	  const char *getCurrentLabel(int &length, bool &inFlash);      //Same, and where it is (true : PROGMEM, false : RAM)
+    const MenuError &error() const { return treeError; }          //What was wrong with the menu (code NONE : nothing)
+		int getCurrentItem();                                         //Returns the number of the current menu item (currentNode)
+    int getAction();            	                                //Returns the action associated to the current item 
+#if defined(ARDUINO)
+		int itemNumber(String find);																	//Returns the number of the first menu item with label "find"
+#endif
+		int itemNumber(const char *find);                             //Same, with a C string (0 : not found)
+		int typeAhead(char key);                                      //Jumps to the next item starting with what was typed so far
+		void typeAheadReset();                                        //Forgets what was typed
+		bool selectItem(int number);																	//Makes item "number" the current item
+		long getListIndex();                                          //Returns the current entry of a list (-1 : not in a list)
+
+    //Lists supplied by the sketch
+		bool attachSource(int node, MenuSource *source);              //The children of "node" are the entries of "source"
+
+    //Changing the menu (only a menu of it's own, not a shared MenuTree) : "currentNode" is kept
+		int insertItem(int parent, int rank, const char *label, int action);  //Adds an item under "parent" (0 : the top) at "rank", returns it's number (0 : failed)
+		bool removeItem(int item);                                    //Removes "item" and it's submenu
+		bool renameItem(int item, const char *label);                 //Changes the label of "item"
+		bool enableItem(int item, bool enabled);                      //Hides (false) or shows again (true) "item" and it's submenu
+
+    //Let the Sketch advise us that
+		void done();                                                  //The action is handled, return to the menu
+    void reset();                                                 //Back to the first item
+
+  private: //====================================================================================================
+    //Default values for the size of the LCD
+    int LCDcol = 16;
+    int LCDrows = 2;
+
+    //The menu is parsed in a MenuTree : "ownTree", or one shared with other Menus.
+    //A node is associated to each item in the menu.
+    //The nodes are placed in the table "nodes[]"
+    //The Menu only reads the tree, thru these copies of it's pointers :
+    MenuObject<MenuTree> ownTree;   //The menu, when it is not shared (on the heap : a pointer when it is, none for a MENU_TABLE until it is changed)
+    bool sharedTree = false;  //true if the tree is an other one (it can't be changed)
+    const char *MYtext; //Where the menu is
+    bool MYflash;       //true if "MYtext" is in flash (PROGMEM)
+    int MYlength;       //The length of the menu
+    const char *MYextra = 0;  //The labels added or changed (from MYlength)
+    int MYextraLength = 0;
+    MenuError treeError;      //What was wrong with the menu (see MenuTree::error())
+    void menuInit(const MenuTree &tree);            //Common part of the constructors
+    void menuInit(const MenuTree *tree);            //Same, for "ownTree" (0 : there was no memory for it)
+    void menuInit(const char *text, int length, const MenuNode *table, int last, const menuIndex *sorted);  //Same, for a MENU_TABLE (no tree yet)
+    bool treeEditable();                            //Before a change : "ownTree" (made for a MENU_TABLE), see MenuTree::editable()
+    void menuSync(const MenuTree &tree);            //Copies the pointers of the tree (after a change)
+    char itemChar(int pos);                         //The character at "pos" in the menu
+    typedef MenuNode node;    //For each item, a node (see MenuNode above)
+	  const node *nodes = 0;    //The table that holds the nodes
+		int updateMenu(int command);	//Update the menu (see MenuCommand)
+		bool needsUpdate;         //The flag to signal that the LCD needs an update or not
+
+    //Labels of the menu or submenu to be displayed on the LCD
+#if defined(ARDUINO)
+    String label(long item); //Returns the label of "item" (see lineItem())
+#endif
+    //Finding labels
+    const menuIndex *byLabel = 0;         //The node numbers, sorted by label (see MenuTree::labelIndex())
+    int labelCount = 0;                   //The number of entries in "byLabel[]"
+    char typed[MENU_TYPEAHEAD];           //What was typed so far (see typeAhead())
+    int typedLength = 0;
+    int labelCompare(int node, const char *find, int length, bool prefix);  //Compares a label to "find"
+    int labelFirst(const char *find, int length, bool prefix);             //Binary search in "byLabel[]"
+
+    long lineItem(int line, bool &caret); //The item displayed on the LCD's "line" (0 : none), "caret" if it is the current one
+    int itemLength(long item);            //The length of the label of "item"
+    char itemLabel(long item, int pos);   //The char at "pos" in the label of "item"
+
+    //What the LCD shows, to redraw only what changed
+    MenuMemory<long> shown;               //The item shown on each row at the last LcdUpdated() (-1 : unknown)
+    int shownCaret = -1;                  //The row that showed the caret (-1 : none)
+    void lcdInvalidate();                 //Forget what the LCD shows
+    char lcdChar(long item, bool caret, int col);  //The char at "col" on a row showing "item"
+
+    //Lists (see MenuSource)
+    struct {                              //The lists attached to nodes
+      menuIndex node;
+      MenuSource *source;
+    } sources[MENU_SOURCES] = {};
+    struct listCopy {                     //A copy of the label of an entry
+      long index;                           //the entry (-1 : none)
+      byte length;                          //the length of the label
+    };
+    MenuSource *list = 0;                 //The list we are in (0 : none)
+    long listCount = 0;                   //The number of entries in the list
+    long listCurrent = 0;                 //The current entry
+    MenuMemory<listCopy> listCache;       //The copies of the labels (a ring, 2 per row of the LCD)
+    MenuMemory<char> listText;            //The labels of the copies (LCDcol chars each)
+    int listEntries = 0;                  //The number of copies
+    int listNext = 0;                     //The next copy to replace
+    MenuSource *sourceOf(int node);       //The list attached to "node"
+    void listEnter(MenuSource *source);   //Enter a list
+    void listLeave();                     //Leave it
+    void listRefresh();                   //Forget the copies of the labels
+    int listEntry(long index);            //The copy of the label of entry "index" (-1 : no copy)
+    int updateList(int command);          //updateMenu(), in a list
+
+    //Moving around the menus
+    int currentNode = 1;            //The index of the current node
+    int lastNode = 1;               //The index of the last node
+    int itemFlags(int node);        //The flags of "node" and of it's parents (0 : it can be reached)
+    bool within(int node, int item);  //"node" is "item" or in it's submenu
+    void itemLeave(int item);       //Moves "currentNode" out of "item" and it's submenu
+    void itemDamage(int item);      //The rows showing "item" (or a removed node) must be redrawn
+    int parent(int node);           //The parent of "node"
+    int eldest(int node);           //The eldest child of "node"
+    int previousSibling(int node);  //The previous sibling of "node"
+    int nextSibling(int node);      //The next sibling of "node"
+    int youngest(int node);         //The youngest child of "node"
+		int siblingsCount(int node);    //The number of siblings of "node"
+    int rank(int node);             //The rank of "node" amongst it's siblings
+    
+
+  //SWITCHES  
+    //The keys provided by the sketch via update(int key) and update(char key), and their commands (see MenuCommand).
+    //A hash table : a key is looked for at "key" modulo MENU_KEYS, then in the next entries, up to an empty one.
+    struct {
+      int key;
+      byte command;                 //MENU_NONE : an empty entry
+      bool isChar;                  //Bound by mapKey(char key, ...)
+    } keyMap[MENU_KEYS] = {};
+    int keyCommand(int key, bool isChar);                   //The command of "key" (MENU_NONE : none)
+    bool keyBind(int key, bool isChar, byte command);       //Binds (or unbinds) "key"
+    void keyForget(byte command, bool isChar);              //Unbinds the keys of "command"
+    bool keysAreChars = false;      //How update(const MenuKey *keys, int count) reads the keys (the last mapKey...())
+
+#if defined(MENU_STATS)
+    //Statistics
+    MenuStats statistics = {};
+    unsigned long statsSince = 0;                       //When counting started (ms)
+    void (*statsExport)(const MenuStats &stats) = 0;    //The hook
+#endif
+
+    //Tasks (see start())
+    MenuTask *tasks[MENU_TASKS] = {}; //The running tasks, in the order they were started
+    int taskCount = 0;                //How many are running
+    void taskRemove(int i);           //Takes task "i" out
+
+    //Key repeat (see keyRepeat())
+    unsigned long repeatHold = 0;   //How long a key is held before jumping (0 : never)
+    unsigned long repeatGap = 0;    //The longest time between two events of a held key
+    int repeatJump = 0;             //How many items to jump (0 : a page)
+    int repeatKey = 0;              //The key being held
+    unsigned long repeatStart = 0;  //When it was pressed
+    unsigned long repeatLast = 0;   //When it was last seen
+};
+
+#endif
@@ -16,8 +16,8 @@
 #include <Wire.h>
 #include <LiquidTWI.h>
 LiquidTWI lcd(0);      //Or the I2C address you have setup your backpack
-int lcdNumCols = 20;
-int lcdNumLines = 4;
+const int lcdNumCols = 20;
+const int lcdNumLines = 4;
 //-----------------------------------------------------------------------------
 
 /////////////////////////////////////////////////////////////////////////////////////////////THE SWITCHES
@@ -53,8 +53,10 @@ char keys[ROWS][COLS] = {
 //  (use "000" to say : "I have a submenu.")
 //Don't forget to place a semi-colon ";" at the end of the last line.
 //That's it, you're done!
+//The menu is kept in flash (PROGMEM) and read from there: only the nodes use RAM.
+//(A "const String menuItems" works too, but the menu then sits in RAM twice.)
 //---------------------------------------------------------------------------
-const String menuItems = 
+const char menuItems[] PROGMEM = 
 "-READ:000"
 "--SENSORS:000"
 "---SENSOR A1:101"
@@ -68,7 +70,7 @@ const String menuItems =
 "-MOVE SERVOS:107"
 "-LONG ROUTINE:108";
 
-Menu menu(menuItems); //Set up menu
+Menu menu((const __FlashStringHelper *) menuItems); //Set up menu
 //---------------------------------------------------------------------------
 
 /////////////////////////////////////////////////////////////////////////////////////////////THE SKETCH
@@ -76,6 +78,7 @@ Menu menu(menuItems); //Set up menu
 #define DOWN '8'
 #define LEFT '4'
 #define RIGHT '6'
+#define CANCEL '#'         //Stops the long routine.
 
 #define ANALOG 1          //For the four actions in the menu READ ("101" to "104").
 #define DIGITAL 0
@@ -88,6 +91,39 @@ int angleServoBase = 90;
 Servo servoArm;
 Servo servoBase;
 
+//LongRoutine==========================================================
+//A long routine that runs in the background ("108").
+//This action takes around 20 minutes to acomplish.
+//In order to let the servos reach destination, we normaly use delays.
+//Instead, each step() checks the time and returns right away :
+//the menu stays usable while the servos move.
+//CANCEL stops it at any point.
+//---------------------------------------------------------------------
+class LongRoutine : public MenuTask {
+  public:
+    void begin() { loops = 1; i = 0; moved = false; }
+    bool step() {
+      const int servoA[4] = {30, 0, 0, 30};
+      const int servoB[4] = {0, 0, 180, 180};
+      const unsigned long timing[4] = {100, 500, 100, 500};   //ms
+      if (!moved) {                                             //Start a move,
+        servoArm.write(servoA[i]);
+        servoBase.write(servoB[i]);
+        started = millis();
+        moved = true;
+      }
+      if (millis() - started < timing[i]) return true;          //and let the servos reach destination.
+      moved = false;
+      if (++i == 4) { i = 0; loops++; }                         //Next move.
+      return loops < 1000;
+    }
+  private:
+    int loops, i;
+    bool moved;
+    unsigned long started;
+};
+LongRoutine longRoutine;
+
 //make==========================================================================================
 //This is where the action is.
 //For each item in the menu that has to do an action,
@@ -102,22 +138,32 @@ void make(int action) {
     case 105: { angleServoArm = changeValue(angleServoArm); break; }
     case 106: { angleServoBase = changeValue(angleServoBase); break; }
     case 107: { servoArm.write(angleServoArm); servoBase.write(angleServoBase); break; }
-    case 108: { bool ErrorFlag = longRoutine(); break; }  //You can act on ErrorFlag before break
+    case 108: {                                                //Runs in the background (see loop()),
+      if (menu.running(&longRoutine)) break;                   //once at a time : a running one is not reset.
+      longRoutine.begin();
+      menu.start(&longRoutine);
+      break;
+    }
   }
 }//make------------------------------------------------------------------------------------------
 
 //showMenu==============================================================
 //Sends the current menu or submenu to your LCD.
-//Updated only if needed.
+//Updated only if needed, and only where it changed :
+//moving the caret rewrites 2 characters, scrolling only the rows that changed.
 //----------------------------------------------------------------------
 void showMenu() {
+  char line[lcdNumCols + 1];                //One line of the LCD (no String, no heap).
+  int first, last;                          //The columns that changed on a line.
   if (menu.LcdNeedsUpdate()) {
-    lcd.clear();
     for (int i = 0 ; i < lcdNumLines ; i++) { 
-      lcd.setCursor(0,i);
-      lcd.print(menu.lcdLine(i)); 
+      if (menu.lcdDamage(i, first, last)) {   //Only the lines that changed,
+        menu.lcdLine(i, line);
+        line[last + 1] = '\0';                 //only the columns that changed.
+        lcd.setCursor(first, i);
+        lcd.print(line + first); 
+      }
     }
-    delay(100);
     menu.LcdUpdated();
   }
 }//showMenu-------------------------------------------------------------
@@ -128,6 +174,12 @@ void setup() {
   lcd.begin(lcdNumCols, lcdNumLines);                  //Setup your LCD.
   menu.defineLcd(lcdNumCols, lcdNumLines);             //Describe your LCD to the Menu Library.
   menu.mapKeyChar(UP, DOWN, LEFT, RIGHT);              //Tell the Menu Library what your keys are.
+  menu.mapKeyCancel(CANCEL);                           //And which one stops the long routine.
+  menu.mapKey('1', MENU_HOME);                         //The keys left on the keypad : the first item,
+  menu.mapKey('7', MENU_END);                          //the last one,
+  menu.mapKey('3', MENU_PAGE_UP);                      //a page up,
+  menu.mapKey('9', MENU_PAGE_DOWN);                    //a page down,
+  menu.mapKey('0', MENU_TOP);                          //and back to the top of the menu.
 
 //Your setup here
   pinMode(4,INPUT_PULLUP);
@@ -138,6 +190,7 @@ void setup() {
 
 //loop======================================================================================
 void loop() {
+  menu.poll();                     //Let the background actions go on.
   showMenu();                      //Update the LCD with the menu.
   char key = keypad.getKey();      //Read the key.
   int action = menu.update(key);   //Read the action tagged to the current menu item.
@@ -205,31 +258,4 @@ int changeValue(int val) {
   }
 }//changeValue-----------------------------------------------------------------------------------------
 
-//longRoutine==========================================================
-//Exiting from a long routine before it's finished.
-//This action takes around 20 minutes to acomplish.
-//In order to let the servos reach destination, we normaly use delays.
-//Replace delays with reading the keypad.
-//This keypad reads around 100000 times per second.
-//Exit if the keypad returns RIGHT at any point.
-//---------------------------------------------------------------------
-bool longRoutine() {
-  int servoA[4] = {30, 0, 0, 30};
-  int servoB[4] = {0, 0, 180, 180};
-  long int timing[4] = {10000, 50000, 10000, 50000};
-
-  lcd.clear(); lcd.setCursor(0, 0); lcd.print(">EXIT");
-
-  for (int loops = 1 ; loops < 1000 ; loops++) {
-    for (int i = 0 ; i < 4 ; i++) {
-      servoArm.write(servoA[i]);
-      servoBase.write(servoB[i]);
-      for (long int timer = 1; timer <= timing[i]; timer++) {
-        if (keypad.getKey() == RIGHT) return true;
-      }
-    }
-  }
-  return false;
-}//longRoutine---------------------------------------------------------
 
-
@@ -0,0 +1,148 @@
+/*
+ * menu_bench : what the menu costs, on a host computer (built by CMakeLists.txt).
+ * Synthetic menus of 10 to 50000 items, in three shapes :
+ *   deep : 2 children per item, as many levels as needed
+ *   wide : 8 children per item
+ *   flat : every item at the top of the menu
+ * are timed on a 20x4 LCD :
+ *   parse  : the constructor (parsing, sorting the labels), per menu
+ *   update : update() per key (random UP, DOWN, LEFT and RIGHT)
+ *   frame  : lcdLine(row, buffer) for the 4 rows, per frame (after each key)
+ *   string : the same with lcdLine(row), the String the example sketch uses
+ *   edit   : insertItem() and removeItem() of a leaf, per pair (should not grow with the menu)
+ * One JSON object per line, to be compared from release to release :
+ *   {"bench":"update","shape":"deep","items":1000,"ns":35.2,"heapBytes":0.0,"heapCalls":0.00,"heldBytes":0}
+ * "ns", "heapBytes" and "heapCalls" are per operation. "heldBytes" : the heap a Menu keeps (parse only).
+ * The heap is counted with glibc only (see heap.h).
+ *
+ *   menu_bench          every menu
+ *   menu_bench --quick  the small ones, a few times (a smoke test, see ctest)
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "heap.h"
+#include "menus.h"
+
+//Measure=========================================================================
+//Times a run of "count" operations, and counts what they took from the heap.
+//--------------------------------------------------------------------------------
+struct Measure {
+  std::chrono::steady_clock::time_point started;
+  unsigned long calls, bytes;
+  Measure() : started(std::chrono::steady_clock::now()), calls(heapCalls), bytes(heapBytes) {}
+  double ns() const { return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count(); }
+  unsigned long heapCallsSince() const { return heapCalls - calls; }
+  unsigned long heapBytesSince() const { return heapBytes - bytes; }
+};
+
+static void report(const char *bench, const char *shape, long items, double ns, double bytes, double calls, long held) {
+  printf("{\"bench\":\"%s\",\"shape\":\"%s\",\"items\":%ld,\"ns\":%.1f,\"heapBytes\":%.1f,\"heapCalls\":%.2f,\"heldBytes\":%ld}\n",
+         bench, shape, items, ns, bytes, calls, held);
+  fflush(stdout);
+}
+
+//run=============================================================================
+//The benchmarks, for one menu.
+//--------------------------------------------------------------------------------
+static void run(const char *shape, long items, int fanout, long keyCount) {
+  const int columns = 20, rows = 4;
+  std::string text = makeMenu(items, fanout);
+
+  //parse
+  int repeat = items < 1000 ? 200 : (items < 10000 ? 20 : 3);
+  if (keyCount < 10000) repeat = 2;
+  long held = 0;
+  {
+    Measure measure;
+    for (int i = 0; i < repeat; i++) {
+      long before = heapHeld;
+      Menu menu(text.c_str());
+      held = heapHeld - before;
+    }
+    report("parse", shape, items, measure.ns() / repeat, (double) measure.heapBytesSince() / repeat,
+           (double) measure.heapCallsSince() / repeat, held);
+  }
+
+  //The keys : UP 20%, DOWN 40%, LEFT 15%, RIGHT 25%, always the same.
+  std::vector<int> keys(keyCount);
+  unsigned long seed = 12345;
+  for (long i = 0; i < keyCount; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    int pick = (seed >> 16) % 100;
+    keys[i] = pick < 20 ? 1 : (pick < 60 ? 2 : (pick < 75 ? 3 : 4));
+  }
+
+  //update, then update and a frame : the frame is the difference.
+  double updateNs;
+  unsigned long updateBytes, updateCalls;
+  {
+    Menu menu(text.c_str());
+    menu.defineLcd(columns, rows);
+    menu.mapKeyInt(1, 2, 3, 4);
+    Measure measure;
+    for (long i = 0; i < keyCount; i++) if (menu.update(keys[i]) > 0) menu.done();
+    updateNs = measure.ns();
+    updateBytes = measure.heapBytesSince();
+    updateCalls = measure.heapCallsSince();
+    report("update", shape, items, updateNs / keyCount, (double) updateBytes / keyCount, (double) updateCalls / keyCount, 0);
+  }
+  {
+    Menu menu(text.c_str());
+    menu.defineLcd(columns, rows);
+    menu.mapKeyInt(1, 2, 3, 4);
+    char line[columns + 1];
+    unsigned long sum = 0;
+    Measure measure;
+    for (long i = 0; i < keyCount; i++) {
+      if (menu.update(keys[i]) > 0) menu.done();
+      for (int row = 0; row < rows; row++) { menu.lcdLine(row, line); sum += line[1]; }
+    }
+    double ns = measure.ns() - updateNs;
+    report("frame", shape, items, ns / keyCount, (double) (measure.heapBytesSince() - updateBytes) / keyCount,
+           (double) (measure.heapCallsSince() - updateCalls) / keyCount, 0);
+    if (sum == 1) printf("\n");                       //(So that the frames are not optimized away.)
+  }
+  {
+    Menu menu(text.c_str());
+    menu.defineLcd(columns, rows);
+    menu.mapKeyInt(1, 2, 3, 4);
+    unsigned long sum = 0;
+    Measure measure;
+    for (long i = 0; i < keyCount; i++) {
+      if (menu.update(keys[i]) > 0) menu.done();
+      for (int row = 0; row < rows; row++) sum += menu.lcdLine(row).length();
+    }
+    double ns = measure.ns() - updateNs;
+    report("string", shape, items, ns / keyCount, (double) (measure.heapBytesSince() - updateBytes) / keyCount,
+           (double) (measure.heapCallsSince() - updateCalls) / keyCount, 0);
+    if (sum == 1) printf("\n");
+  }
+  {                                                   //edit : insertItem() then removeItem() of a leaf,
+                                                      //the youngest, it's label sorted last (no ranks, no label moved).
+    Menu menu(text.c_str());
+    menu.defineLcd(columns, rows);
+    long count = keyCount / 10;
+    Measure measure;
+    for (long i = 0; i < count; i++) menu.removeItem(menu.insertItem(0, 1 << 30, "ZZ BENCH", 1));
+    report("edit", shape, items, measure.ns() / count, (double) measure.heapBytesSince() / count,
+           (double) measure.heapCallsSince() / count, 0);
+  }
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  const long sizes[] = {10, 100, 1000, 10000, 50000};
+  for (long items : sizes) {
+    if (quick && items > 1000) break;
+    long keyCount = quick ? 1000 : 200000;
+    run("deep", items, 2, keyCount);
+    run("wide", items, 8, keyCount);
+    run("flat", items, (int) items, keyCount);
+  }
+  return 0;
+}
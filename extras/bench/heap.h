@@ -0,0 +1,50 @@
+/*
+ * heap.h : what the benchmarks take from the heap (include it in one file per executable).
+ * Every malloc(), calloc() and realloc() is counted (glibc : the real ones are __libc_...()).
+ * Counted with glibc only (0 elsewhere, and with MENU_SANITIZE). The counters may be read from any thread.
+ */
+#ifndef heap_h
+#define heap_h
+
+#include <atomic>
+
+static std::atomic<unsigned long> heapCalls(0);   //Blocks asked for
+static std::atomic<unsigned long> heapBytes(0);   //Bytes asked for
+static std::atomic<long> heapHeld(0);             //Bytes in use
+
+#if defined(__GLIBC__) && !defined(MENU_SANITIZE)
+#include <malloc.h>
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *block, size_t size);
+  void __libc_free(void *block);
+
+  void *malloc(size_t size) {
+    void *block = __libc_malloc(size);
+    heapCalls++; heapBytes += size;
+    if (block) heapHeld += malloc_usable_size(block);
+    return block;
+  }
+  void *calloc(size_t count, size_t size) {
+    void *block = __libc_calloc(count, size);
+    heapCalls++; heapBytes += count * size;
+    if (block) heapHeld += malloc_usable_size(block);
+    return block;
+  }
+  void *realloc(void *block, size_t size) {
+    long before = block ? (long) malloc_usable_size(block) : 0;
+    void *moved = __libc_realloc(block, size);
+    heapCalls++; heapBytes += size;
+    if (moved) heapHeld += (long) malloc_usable_size(moved) - before;
+    else if (size == 0) heapHeld -= before;
+    return moved;
+  }
+  void free(void *block) {
+    if (block) heapHeld -= malloc_usable_size(block);
+    __libc_free(block);
+  }
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * menu_layout : the node layout, against the one it replaced (built by CMakeLists.txt).
+ *   old : two ints for the label (start and end) and an int action, as the library had them
+ *   new : MenuNode, a label offset, an 8 bit length and a 16 bit action
+ * The same trees (10 to 50000 items, 8 children per item) are built in both layouts, then :
+ *   walk   : per key, a random UP, DOWN, LEFT or RIGHT, then the rows of a 20x4 LCD (as update() and lineItem())
+ *   lookup : per item, the label and action of a random node (as itemNumber() and the label index)
+ * One JSON object per line : the bytes per node and per table, and the ns per operation.
+ *   {"bench":"walk","layout":"new","items":1000,"nodeBytes":20,"tableBytes":20020,"ns":4.1}
+ *
+ *   menu_layout          every size
+ *   menu_layout --quick  the small ones (a smoke test, see ctest)
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+//The layout it replaced : the label as two ints, an int action.
+struct OldNode {
+  int starts = 0;
+  int ends = 0;
+  menuIndex parent = 0;
+  menuIndex eldest = 1;
+  menuIndex previous = 0;
+  menuIndex next = 0;
+  menuIndex rank = 1;
+  menuIndex children = 0;
+  int action = 0;
+};
+
+static void setLabel(OldNode &n, long start, int length) { n.starts = start; n.ends = start + length; }
+static void setLabel(MenuNode &n, long start, int length) { n.start = start; n.length = length; }
+static int labelLength(const OldNode &n) { return n.ends - n.starts; }
+static int labelLength(const MenuNode &n) { return n.length; }
+static long labelStart(const OldNode &n) { return n.starts; }
+static long labelStart(const MenuNode &n) { return n.start; }
+
+//build===========================================================================
+//A tree of "items" items, "fanout" children per item, numbered as the parser does
+//(depth first), with labels of 6 to 13 chars one after the other.
+//--------------------------------------------------------------------------------
+template <typename N> static void grow(std::vector<N> &nodes, int parent, int fanout, long items, long &pos) {
+  int older = 0;
+  long first = (long) nodes.size();
+  for (int i = 0; i < fanout && (long) nodes.size() <= items; i++) {
+    int item = (int) nodes.size();
+    nodes.push_back(N());
+    N &n = nodes[item];
+    int length = 6 + item % 8;
+    setLabel(n, pos, length);
+    pos += length + 5;
+    n.action = item % 1000;
+    n.parent = parent;
+    n.next = item;
+    if (older == 0) n.previous = item;
+    else {
+      n.previous = older;
+      nodes[older].next = item;
+      n.rank = nodes[older].rank + 1;
+      nodes[first].previous = item;
+    }
+    nodes[parent].children++;
+    if (i == 0) nodes[parent].eldest = item;
+    older = item;
+  }
+  for (int child = (int) first; child < (int) nodes.size() && child - first < fanout; child++) {
+    if ((long) nodes.size() > items) break;
+    if (child % 3 != 0) grow(nodes, child, fanout, items, pos);   //Two out of three have no submenu.
+  }
+}
+
+template <typename N> static std::vector<N> build(long items, int fanout) {
+  std::vector<N> nodes(1);
+  nodes.reserve(items + 1);
+  long pos = 0;
+  while ((long) nodes.size() <= items) {
+    long before = (long) nodes.size();
+    grow(nodes, 0, fanout, items, pos);
+    if ((long) nodes.size() == before) break;
+    fanout *= 2;                                                   //Wider at the top, until all are there.
+  }
+  return nodes;
+}
+
+//walk=============================================================================
+//"keys" random moves, then the 4 rows of the LCD after each one. Returns ns per key.
+//---------------------------------------------------------------------------------
+template <typename N> static double walk(const std::vector<N> &nodes, const std::vector<int> &keys, unsigned long &sum) {
+  const int rows = 4;
+  int current = nodes[0].eldest;
+  auto started = std::chrono::steady_clock::now();
+  for (int key : keys) {
+    const N &n = nodes[current];
+    switch (key) {
+      case 0: if (n.rank > 1) current = n.previous; break;
+      case 1: current = n.next; break;
+      case 2: if (n.parent != 0) current = n.parent; break;
+      case 3: if (n.children > 0) current = n.eldest; break;
+    }
+    int row = nodes[current].rank > rows ? current : nodes[nodes[current].parent].eldest;
+    for (int i = 0; i < rows; i++) {                              //The rows : labels and carets.
+      const N &shown = nodes[row];
+      sum += labelStart(shown) + labelLength(shown) + (row == current);
+      if ((int) shown.next == row) break;
+      row = shown.next;
+    }
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / keys.size();
+}
+
+//lookup============================================================================
+//The label and action of random nodes. Returns ns per node.
+//----------------------------------------------------------------------------------
+template <typename N> static double lookup(const std::vector<N> &nodes, const std::vector<int> &picks, unsigned long &sum) {
+  auto started = std::chrono::steady_clock::now();
+  for (int item : picks) {
+    const N &n = nodes[item];
+    sum += labelStart(n) + labelLength(n) + n.action;
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / picks.size();
+}
+
+static void report(const char *bench, const char *layout, long items, size_t nodeBytes, double ns) {
+  printf("{\"bench\":\"%s\",\"layout\":\"%s\",\"items\":%ld,\"nodeBytes\":%zu,\"tableBytes\":%zu,\"ns\":%.2f}\n",
+         bench, layout, items, nodeBytes, nodeBytes * (items + 1), ns);
+  fflush(stdout);
+}
+
+template <typename N> static void run(const char *layout, long items, const std::vector<int> &keys, const std::vector<int> &picks) {
+  std::vector<N> nodes = build<N>(items, 8);
+  if ((long) nodes.size() != items + 1) { printf("%s : %zu nodes instead of %ld\n", layout, nodes.size() - 1, items); exit(1); }
+  unsigned long sum = 0;
+  walk(nodes, keys, sum);                                          //(Once to warm up.)
+  report("walk", layout, items, sizeof(N), walk(nodes, keys, sum));
+  std::vector<int> inRange(picks);
+  for (int &item : inRange) item = 1 + item % items;
+  lookup(nodes, inRange, sum);
+  report("lookup", layout, items, sizeof(N), lookup(nodes, inRange, sum));
+  if (sum == 1) printf("\n");                                      //(So that nothing is optimized away.)
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  long count = quick ? 10000 : 2000000;
+  std::vector<int> keys(count), picks(count);
+  unsigned long seed = 12345;
+  for (long i = 0; i < count; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    int pick = (seed >> 16) % 100;
+    keys[i] = pick < 20 ? 0 : (pick < 60 ? 1 : (pick < 75 ? 2 : 3));  //UP 20%, DOWN 40%, LEFT 15%, RIGHT 25%
+    picks[i] = (int) ((seed >> 8) & 0x7fffffff);
+  }
+  const long sizes[] = {10, 100, 1000, 10000, 50000};
+  for (long items : sizes) {
+    if (quick && items > 1000) break;
+    if (items > MENU_MAX_ITEMS) break;
+    run<OldNode>("old", items, keys, picks);
+    run<MenuNode>("new", items, keys, picks);
+  }
+  return 0;
+}
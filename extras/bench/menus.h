@@ -0,0 +1,39 @@
+/*
+ * menus.h : the synthetic menus of the benchmarks.
+ */
+#ifndef menus_h
+#define menus_h
+
+#include <stdio.h>
+#include <string>
+
+//makeMenu========================================================================
+//A menu of "items" items, "fanout" children per item, on up to "depth" levels.
+//The items with children have the action 000, the others 001 to 999.
+//The labels are padded with dots to "width" chars, "end" follows each item (e.g. "\n" : a file).
+//--------------------------------------------------------------------------------
+static void grow(std::string &text, int level, int fanout, int depth, long &left, int width, const char *end) {
+  for (int i = 0; i < fanout && left > 0; i++) {
+    long number = left--;
+    text.append(level, '-');
+    std::string label = "ITEM " + std::to_string(number);
+    if ((int) label.length() < width) label.append(width - label.length(), '.');
+    text += label;
+    char action[8];
+    snprintf(action, sizeof(action), ":%03ld", level < depth ? 0L : 1 + number % 999);
+    text += action;
+    text += end;
+    if (level < depth) grow(text, level + 1, fanout, depth, left, width, end);
+  }
+}
+
+static std::string makeMenu(long items, int fanout, int width = 0, const char *end = "") {
+  int depth = 1;
+  for (long reach = fanout; reach < items; reach = reach * fanout + fanout) depth++;  //Enough levels for the items.
+  std::string text;
+  long left = items;
+  grow(text, 1, fanout, depth, left, width, end);
+  return text;
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * menu_sessions : Menus sharing one MenuTree, one per thread (built by CMakeLists.txt).
+ *   memory : what a session costs, sharing the tree or with a tree of it's own (sizeof(Menu) + heap)
+ *   keys   : 1 to 8 threads, each one with it's own Menu on the shared tree, the same random keys
+ *            and a frame (the 4 rows of a 20x4 LCD) after each one. The keys per second, all threads together.
+ * Every session must end on the same item, with the same frames, as a single one : the tree is only read.
+ * Built with -DMENU_TSAN=ON, ThreadSanitizer checks that (see ctest).
+ * One JSON object per line :
+ *   {"bench":"keys","threads":4,"items":10000,"keysPerSecond":81234567,"speedup":3.9}
+ *
+ *   menu_sessions          10000 items, 2000000 keys per thread
+ *   menu_sessions --quick  1000 items, 20000 keys per thread, 1 and 2 threads
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "heap.h"
+#include "menus.h"
+
+const int columns = 20, rows = 4;
+
+struct Session {
+  int item = 0;                   //Where it ended
+  unsigned long frames = 0;       //A sum of what it showed
+  double seconds = 0;
+};
+
+//session=========================================================================
+//One operator : a Menu on "tree", the keys, a frame after each one.
+//--------------------------------------------------------------------------------
+static void session(const MenuTree &tree, const std::vector<int> &keys, Session &result) {
+  Menu menu(tree);
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(1, 2, 3, 4);
+  char line[columns + 1];
+  auto started = std::chrono::steady_clock::now();
+  for (int key : keys) {
+    if (menu.update(key) > 0) menu.done();
+    for (int row = 0; row < rows; row++) {
+      menu.lcdLine(row, line);
+      for (int col = 0; col < columns; col++) result.frames = result.frames * 31 + (unsigned char) line[col];
+    }
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  result.item = menu.getCurrentItem();
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  long items = quick ? 1000 : 10000;
+  if (items > MENU_MAX_ITEMS) items = MENU_MAX_ITEMS;
+  long keyCount = quick ? 20000 : 2000000;
+  std::string text = makeMenu(items, 8);
+  MenuTree tree(text.c_str());
+
+  //memory
+  {
+    long before = heapHeld;
+    Menu shared(tree);
+    shared.defineLcd(columns, rows);
+    long sharedHeap = heapHeld - before;
+    before = heapHeld;
+    Menu own(text.c_str());
+    own.defineLcd(columns, rows);
+    long ownHeap = heapHeld - before;
+    printf("{\"bench\":\"memory\",\"session\":\"shared\",\"items\":%ld,\"menuBytes\":%zu,\"heapBytes\":%ld,\"bytes\":%ld}\n",
+           items, sizeof(Menu), sharedHeap, (long) sizeof(Menu) + sharedHeap);
+    printf("{\"bench\":\"memory\",\"session\":\"own\",\"items\":%ld,\"menuBytes\":%zu,\"heapBytes\":%ld,\"bytes\":%ld}\n",
+           items, sizeof(Menu), ownHeap, (long) sizeof(Menu) + ownHeap);
+  }
+
+  //The keys : UP 20%, DOWN 40%, LEFT 15%, RIGHT 25%, always the same.
+  std::vector<int> keys(keyCount);
+  unsigned long seed = 12345;
+  for (long i = 0; i < keyCount; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    int pick = (seed >> 16) % 100;
+    keys[i] = pick < 20 ? 1 : (pick < 60 ? 2 : (pick < 75 ? 3 : 4));
+  }
+
+  //keys
+  Session alone;
+  session(tree, keys, alone);
+  double single = keyCount / alone.seconds;
+  int failures = 0;
+  for (int threads = 1; threads <= (quick ? 2 : 8); threads *= 2) {
+    std::vector<Session> results(threads);
+    std::vector<std::thread> running;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; i++) running.emplace_back(session, std::cref(tree), std::cref(keys), std::ref(results[i]));
+    for (std::thread &thread : running) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (const Session &result : results) {
+      if (result.item != alone.item || result.frames != alone.frames) failures++;
+    }
+    double perSecond = threads * keyCount / seconds;
+    printf("{\"bench\":\"keys\",\"threads\":%d,\"cores\":%u,\"items\":%ld,\"keysPerSecond\":%.0f,\"speedup\":%.2f}\n",
+           threads, std::thread::hardware_concurrency(), items, perSecond, perSecond / single);
+    fflush(stdout);
+  }
+  if (failures) printf("%d sessions did not see what a single one sees\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * menu_throughput : how fast a menu is read, in MB/s (built by CMakeLists.txt).
+ * Synthetic menus of 1 to 16 MB (as many items as the node numbers allow, see MENU_INDEX_BITS,
+ * the labels padded to fill the size), in three shapes :
+ *   deep : 2 children per item
+ *   wide : 8 children per item
+ *   file : 8 children per item, one item per line (a menu read from a file)
+ * are read by the constructor : the parsing and the sorting of the labels, as a sketch gets them.
+ * One JSON object per line, the best of a few runs :
+ *   {"bench":"throughput","shape":"file","bytes":16777190,"items":65535,"ms":41.2,"MBps":388.3}
+ * A menu that can't be read (too long for the offsets of 8 bit node numbers) says so in "error".
+ *
+ *   menu_throughput          every size
+ *   menu_throughput --quick  32 KB menus (a smoke test, see ctest)
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "menus.h"
+
+static void run(const char *shape, long bytes, int fanout, const char *end, int repeat) {
+  long items = bytes / 20;                                    //An item : "ITEM n" padded to 12 chars, ":000" and dashes.
+  int width = 12;
+  if (items > MENU_MAX_ITEMS) {                               //Fewer items, longer labels.
+    items = MENU_MAX_ITEMS;
+    width = bytes / items - 8;
+    if (width > 255) width = 255;
+  }
+  std::string text = makeMenu(items, fanout, width, end);
+
+  double best = 0;
+  int code = MenuTable::NONE;
+  for (int i = 0; i < repeat; i++) {
+    auto started = std::chrono::steady_clock::now();
+    Menu menu(text.c_str());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    code = menu.error().code;
+    if (i == 0 || ms < best) best = ms;
+  }
+  if (code != MenuTable::NONE) {
+    printf("{\"bench\":\"throughput\",\"shape\":\"%s\",\"bytes\":%lu,\"items\":%ld,\"error\":%d}\n",
+           shape, (unsigned long) text.length(), items, code);
+  }
+  else {
+    printf("{\"bench\":\"throughput\",\"shape\":\"%s\",\"bytes\":%lu,\"items\":%ld,\"ms\":%.2f,\"MBps\":%.1f}\n",
+           shape, (unsigned long) text.length(), items, best, text.length() / 1e6 / (best / 1000));
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  const long sizes[] = {1L << 20, 4L << 20, 16L << 20};
+  for (long bytes : sizes) {
+    if (quick) bytes = 32L << 10;
+    int repeat = quick ? 2 : 5;
+    run("deep", bytes, 2, "", repeat);
+    run("wide", bytes, 8, "", repeat);
+    run("file", bytes, 8, "\n", repeat);
+    if (quick) break;
+  }
+  return 0;
+}
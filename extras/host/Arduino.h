@@ -0,0 +1,124 @@
+/*
+ * Arduino.h (host)
+ * Just enough of the Arduino core to build the library on a host computer (Linux), with it's String parts :
+ * byte, String, PROGMEM, F(), millis(), micros() and Print. See CMakeLists.txt.
+ * There is no flash here : PROGMEM data is plain memory, and pgm_read_byte() reads it as such.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef uint8_t byte;
+
+//Flash (PROGMEM)==============================================================
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define strlen_P strlen
+#define memchr_P memchr
+class __FlashStringHelper;
+#define F(text) ((const __FlashStringHelper *) (text))
+
+//Time=========================================================================
+inline unsigned long micros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+inline unsigned long millis() { return micros() / 1000; }
+
+//String=======================================================================
+//Arduino's String : a '\0' terminated copy on the heap (malloc(), as on the board).
+//Only what the library and the example sketch use.
+//-----------------------------------------------------------------------------
+class String {
+  public:
+    String(const char *text = "") { copy(text, strlen(text)); }
+    String(char c) { copy(&c, 1); }
+    String(const String &other) { copy(other.c_str(), other.len); }
+    String(String &&other) : buffer(other.buffer), len(other.len), capacity(other.capacity) {
+      other.buffer = 0; other.len = other.capacity = 0;
+    }
+    ~String() { free(buffer); }
+    String &operator=(const String &other) {
+      if (this != &other) { free(buffer); copy(other.c_str(), other.len); }
+      return *this;
+    }
+    String &operator=(String &&other) {
+      if (this != &other) {
+        free(buffer);
+        buffer = other.buffer; len = other.len; capacity = other.capacity;
+        other.buffer = 0; other.len = other.capacity = 0;
+      }
+      return *this;
+    }
+
+    unsigned int length() const { return len; }
+    const char *c_str() const { return buffer ? buffer : ""; }
+    bool reserve(unsigned int size) {
+      if (size <= capacity && buffer) return true;
+      char *grown = (char *) realloc(buffer, size + 1);
+      if (!grown) return false;
+      if (!buffer) grown[0] = '\0';
+      buffer = grown;
+      capacity = size;
+      return true;
+    }
+    bool concat(const char *text, unsigned int size) {
+      if (size == 0) return true;
+      if (!reserve(len + size)) return false;
+      memcpy(buffer + len, text, size);
+      len += size;
+      buffer[len] = '\0';
+      return true;
+    }
+    String &operator+=(char c) { concat(&c, 1); return *this; }
+    String &operator+=(const char *text) { concat(text, strlen(text)); return *this; }
+    String &operator+=(const String &other) { concat(other.c_str(), other.len); return *this; }
+    char charAt(unsigned int i) const { return i < len ? buffer[i] : '\0'; }
+    String substring(unsigned int from, unsigned int to) const {
+      if (to > len) to = len;
+      String part;
+      if (from < to) part.concat(buffer + from, to - from);
+      return part;
+    }
+    long toInt() const { return atol(c_str()); }
+    bool operator==(const String &other) const { return len == other.len && memcmp(c_str(), other.c_str(), len) == 0; }
+    bool operator!=(const String &other) const { return !(*this == other); }
+
+  private:
+    char *buffer = 0;
+    unsigned int len = 0;
+    unsigned int capacity = 0;
+    void copy(const char *text, unsigned int size) {
+      buffer = 0; len = capacity = 0;
+      concat(text, size);
+    }
+};
+inline String operator+(const String &a, const String &b) { String sum(a); sum += b; return sum; }
+
+//Print========================================================================
+//Arduino's Print : everything goes thru write() (e.g. Serial, an LCD).
+//-----------------------------------------------------------------------------
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char *text, size_t size) { size_t n = 0; while (size--) n += write((uint8_t) *text++); return n; }
+    size_t print(const char *text) { return write(text, strlen(text)); }
+    size_t print(const __FlashStringHelper *text) { return print((const char *) text); }
+    size_t print(const String &text) { return write(text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(long n) { char digits[24]; snprintf(digits, sizeof(digits), "%ld", n); return print(digits); }
+    size_t print(unsigned long n) { char digits[24]; snprintf(digits, sizeof(digits), "%lu", n); return print(digits); }
+    size_t print(int n) { return print((long) n); }
+    size_t println() { return print("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * menuc : the menu compiler
+ * Parses a menu once, on the host computer, and writes it's image (see MenuImage in Menu.h).
+ * The board then uses the image as it is : nothing to parse at boot.
+ *
+ * Build it with the MENU_INDEX_BITS of the board (8 for AVR, 16 elsewhere) :
+ *   g++ -I../.. -DMENU_INDEX_BITS=8 -o menuc menuc.cpp ../../Menu.cpp
+ *
+ * The menu file holds the items as in the sketch but without the quotes, one per line if you like :
+ *   -READ:000
+ *   --SENSORS:000
+ *   ...
+ *
+ *   menuc menu.txt menu.bin            The image, for an SD card, an EEPROM or mmap()
+ *   menuc -c menuImage menu.txt menu.h The image as an array in PROGMEM, for the sketch :
+ *                                      #include "menu.h"
+ *                                      Menu menu((const MenuImage *) menuImage, sizeof(menuImage), true);  //true : in PROGMEM (AVR)
+ *
+ * A malformed menu makes no image : menuc tells what is wrong, and on which line.
+ */
+#include <Menu.h>
+#include <stdio.h>
+
+//readMenu==========================================================================
+//Reads the menu file (the parser skips the line ends), "length" chars. Returns 0 if the file
+//can't be read, or if there is no memory for it (see errno).
+//----------------------------------------------------------------------------------
+static char *readMenu(const char *name, long &length) {
+  FILE *file = fopen(name, "rb");
+  if (!file) return 0;
+  long size = 0;
+  length = 0;
+  char *text = 0;
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    if (length + 1 >= size) {
+      size = size ? size * 2 : 4096;
+      char *grown = (char *) realloc(text, size);
+      if (!grown) {
+        free(text);
+        fclose(file);
+        return 0;
+      }
+      text = grown;
+    }
+    text[length++] = c;
+  }
+  fclose(file);
+  if (!text) text = (char *) calloc(1, 1);
+  if (!text) return 0;
+  text[length] = '\0';
+  return text;
+}//readMenu-------------------------------------------------------------------------
+
+//errorText=========================================================================
+//What is wrong with the menu (see MenuError in Menu.h).
+//----------------------------------------------------------------------------------
+static const char *errorText(int code) {
+  switch (code) {
+    case MenuTable::NO_ITEMS: return "the menu is empty";
+    case MenuTable::NO_DASH: return "the menu must start with a dash";
+    case MenuTable::MISSING_COLON: return "the item has no ':'";
+    case MenuTable::BAD_ACTION: return "the action is not exactly 3 digits";
+    case MenuTable::LEVEL_JUMP: return "the item is more than one level deeper than the one before";
+    case MenuTable::TOO_MANY_ITEMS: return "more items than MENU_INDEX_BITS allows";
+    case MenuTable::NO_MEMORY: return "out of memory";
+    case MenuTable::LONG_LABEL: return "the label is longer than 255 chars";
+    case MenuTable::LONG_MENU: return "the menu is longer than MENU_INDEX_BITS allows";
+  }
+  return "unknown error";
+}//errorText------------------------------------------------------------------------
+
+//writeArray========================================================================
+//Writes the image as a C array, kept in flash (PROGMEM) and aligned for 32 bits boards.
+//----------------------------------------------------------------------------------
+static void writeArray(FILE *file, const char *name, const unsigned char *image, long size) {
+  fprintf(file, "//Made by menuc (MENU_INDEX_BITS %d). Do not edit.\n", MENU_INDEX_BITS);
+  fprintf(file, "alignas(4) const unsigned char %s[%ld] PROGMEM = {", name, size);
+  for (long i = 0; i < size; i++) fprintf(file, "%s0x%02x%s", i % 16 ? "" : "\n  ", image[i], i + 1 < size ? "," : "");
+  fprintf(file, "\n};\n");
+}//writeArray-----------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+  const char *array = 0;
+  if (argc == 5 && strcmp(argv[1], "-c") == 0) { array = argv[2]; argv += 2; argc -= 2; }
+  if (argc != 3) {
+    fprintf(stderr, "usage : menuc [-c arrayName] menu.txt image\n");
+    return 2;
+  }
+  long length;
+  char *text = readMenu(argv[1], length);
+  if (!text) { perror(argv[1]); return 1; }
+  long size;
+  unsigned char *image;
+  {
+    MenuTree tree(text, length);                //Parse it, as the board would.
+    const MenuError &error = tree.error();
+    if (error.code != MenuTable::NONE) {
+      fprintf(stderr, "%s:%ld: item %ld (character %ld) : %s\n", argv[1], error.line, error.item, error.offset, errorText(error.code));
+      free(text);
+      return 1;
+    }
+    size = tree.image(0, 0);
+    image = (unsigned char *) malloc(size);
+    if (!image) {
+      fprintf(stderr, "menuc : %s\n", errorText(MenuTable::NO_MEMORY));
+      free(text);
+      return 1;
+    }
+    tree.image(image, size);
+  }
+  if (MenuTree::imageCheck((const MenuImage *) image, size) != size) {
+    fprintf(stderr, "menuc : the image of %s is not valid\n", argv[1]);
+    return 1;
+  }
+  FILE *file = fopen(argv[2], array ? "w" : "wb");
+  if (!file) { perror(argv[2]); return 1; }
+  if (array) writeArray(file, array, image, size);
+  else fwrite(image, 1, size, file);
+  fclose(file);
+  fprintf(stderr, "menuc : %s, %ld items, %ld bytes\n", argv[2], (long) ((const MenuImage *) image)->nodes, size);
+  free(image);
+  free(text);
+  return 0;
+}
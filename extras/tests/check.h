@@ -0,0 +1,21 @@
+/*
+ * check.h : what the host tests share (see CMakeLists.txt).
+ * CHECK() reports a failed condition with it's line and goes on; a test returns checkResult() from main().
+ */
+#ifndef check_h
+#define check_h
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(condition) \
+  do { if (!(condition)) { checkFailures++; printf("%s:%d: failed : %s\n", __FILE__, __LINE__, #condition); } } while (0)
+
+static inline int checkResult(const char *test) {
+  if (checkFailures) printf("%s : %d failed\n", test, checkFailures);
+  else printf("%s : ok\n", test);
+  return checkFailures ? 1 : 0;
+}
+
+#endif
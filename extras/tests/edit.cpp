@@ -0,0 +1,129 @@
+/*
+ * edit : changing the menu while the sketch runs (insertItem(), removeItem(), renameItem(), enableItem()).
+ *   release : a hidden item in a removed submenu is freed with it, and can't be shown again
+ *   nested  : the same, hidden in a hidden submenu
+ *   select  : selectItem() refuses the items that can't be reached, and the LCD rows still come back
+ *   table   : a MENU_TABLE can be changed too (it then gets a tree of it's own)
+ *   labels  : a label longer than 255 chars is refused, getCurrentLabel() says where a label is
+ */
+#include <Menu.h>
+#include <string.h>
+#include "check.h"
+
+static bool currentIs(Menu &menu, const char *label) {
+  int length;
+  const char *text = menu.getCurrentLabel(length);
+  return length == (int) strlen(label) && memcmp(text, label, length) == 0;
+}
+
+static void release() {
+  Menu menu(String("-READ:000--SENSORS:000---SENSOR A1:101---SENSOR A2:102--SWITCHES:000-SET:000--SERVO ARM:105"));
+  menu.defineLcd(20, 4);
+  int hidden = menu.itemNumber("SENSOR A2");
+  CHECK(menu.enableItem(hidden, false));
+  CHECK(menu.removeItem(menu.itemNumber("SENSORS")));
+  CHECK(menu.itemNumber("SENSOR A2") == 0);                     //Out of "byLabel[]",
+  int set = menu.itemNumber("SET");
+  CHECK(menu.insertItem(set, 99, "NEWA", 1) != 0);               //and it's node used again,
+  CHECK(menu.insertItem(set, 99, "NEWB", 2) != 0);
+  CHECK(menu.insertItem(set, 99, "NEWC", 3) != 0);
+  CHECK(menu.itemNumber("SENSOR A2") == 0);
+  for (int item = 1; item < 10; item++) {                       //like the other ones.
+    if (menu.itemNumber("NEWA") != item && menu.itemNumber("NEWB") != item && menu.itemNumber("NEWC") != item) continue;
+    CHECK(menu.enableItem(item, true));                          //(Already shown.)
+  }
+  int newb = menu.itemNumber("NEWB");
+  CHECK(menu.selectItem(newb));
+  CHECK(menu.getAction() == 2);
+  CHECK(menu.insertItem(menu.itemNumber("READ"), 99, "NEWD", 4) != 0);  //No other node is left over.
+}
+
+//Hidden in hidden : the whole submenu is freed, whatever is hidden in there.
+static void nested() {
+  Menu menu(String("-A:000--B:000---C:001---D:002--E:003-F:004"));
+  int a = menu.itemNumber("A"), b = menu.itemNumber("B"), d = menu.itemNumber("D");
+  CHECK(menu.enableItem(d, false));
+  CHECK(menu.enableItem(b, false));
+  CHECK(menu.removeItem(a));
+  const char *gone[] = {"A", "B", "C", "D", "E"};
+  for (const char *label : gone) CHECK(menu.itemNumber(label) == 0);
+  int f = menu.itemNumber("F");
+  char label[] = "NEW0";
+  for (int i = 0; i < 5; i++) {                                 //The 5 nodes are used again,
+    label[3] = '0' + i;
+    int item = menu.insertItem(f, 99, label, 10 + i);
+    CHECK(item != 0 && item <= 6);
+  }
+  CHECK(!menu.enableItem(b, true) || menu.itemNumber("B") == 0);  //and nothing hidden comes back.
+  CHECK(!menu.enableItem(d, true) || menu.itemNumber("D") == 0);
+  CHECK(menu.insertItem(f, 99, "NEW5", 20) == 7);               //(A new node : none was left over.)
+}
+
+static void select() {
+  Menu menu(String("-A:000--A1:001--A2:002-B:000"));
+  menu.defineLcd(20, 4);
+  int a = menu.itemNumber("A"), a2 = menu.itemNumber("A2");
+  CHECK(menu.enableItem(a2, false));
+  CHECK(menu.insertItem(a, 99, "A3", 3) != 0);
+  CHECK(menu.insertItem(a, 99, "A4", 4) != 0);
+  int current = menu.getCurrentItem();
+  CHECK(!menu.selectItem(a2));                                  //Hidden,
+  CHECK(!menu.selectItem(0));                                   //not an item,
+  CHECK(!menu.selectItem(99));
+  CHECK(menu.getCurrentItem() == current);                      //so it stays.
+  char line[21];
+  for (int row = 0; row < 4; row++) menu.lcdLine(row, line);    //(It used to never return.)
+  CHECK(menu.selectItem(menu.itemNumber("A4")));
+  menu.lcdLine(2, line);                                        //A1, A3, A4 (A2 is hidden).
+  CHECK(strcmp(line, ">A4                 ") == 0);
+  CHECK(menu.removeItem(a));
+  CHECK(!menu.selectItem(a2));                                  //Removed with it's parent.
+}
+
+//A MENU_TABLE is read where it is, until it is changed : then it gets a tree of it's own.
+static void table() {
+#if __cplusplus >= 201402L
+  MENU_TABLE(items, "-A:000--A1:001--A2:002-B:003");
+  Menu menu(items);
+  int a = menu.itemNumber("A");
+  CHECK(menu.insertItem(a, 1, "A0", 4) != 0);
+  CHECK(menu.renameItem(menu.itemNumber("B"), "C"));
+  CHECK(menu.itemNumber("A0") != 0 && menu.itemNumber("C") != 0 && menu.itemNumber("B") == 0);
+  CHECK(menu.selectItem(menu.itemNumber("A0")));
+  CHECK(menu.getAction() == 4);
+  Menu other(items);                                            //(The table did not change.)
+  CHECK(other.itemNumber("B") == 4 && other.itemNumber("A0") == 0);
+#endif
+}
+
+static void labels() {
+  char longLabel[300];
+  memset(longLabel, 'X', sizeof(longLabel) - 1);
+  longLabel[sizeof(longLabel) - 1] = '\0';
+  static const char items[] PROGMEM = "-ONE:001-TWO:002";
+  Menu menu(F(items));
+  int one = menu.itemNumber("ONE");
+  CHECK(menu.insertItem(0, 99, longLabel, 3) == 0);            //Too long : refused,
+  CHECK(!menu.renameItem(one, longLabel));
+  CHECK(currentIs(menu, "ONE"));                                //and the label stays.
+  longLabel[255] = '\0';
+  CHECK(menu.insertItem(0, 99, longLabel, 3) != 0);            //255 : ok.
+
+  int length;
+  bool inFlash;
+  menu.getCurrentLabel(length, inFlash);
+  CHECK(inFlash);                                               //Read where it is,
+  CHECK(menu.renameItem(one, "UNO"));
+  const char *text = menu.getCurrentLabel(length, inFlash);
+  CHECK(!inFlash);                                              //a copy in RAM once renamed.
+  CHECK(length == 3 && memcmp(text, "UNO", 3) == 0);
+}
+
+int main() {
+  release();
+  nested();
+  select();
+  table();
+  labels();
+  return checkResult("edit");
+}
@@ -0,0 +1,148 @@
+/*
+ * fuzz : malformed menus, and random keys and edits on what was read.
+ * An input is a menu, then a '\0', then the operations : one byte each (a key, typeAhead(), an edit).
+ * For every input :
+ *   the parser stops on an error, with a line and an offset inside the menu,
+ *   without line ends, it finds the same error as MenuTable::check() (the compile time check),
+ *   the operations never leave the current item out of the menu, and the rows of the LCD always come back.
+ * Two ways to run it :
+ *   fuzz [runs]         random mutations of a few good menus (20000 by default, a ctest)
+ *   fuzz file ...       the inputs in the files (e.g. what libFuzzer found)
+ *   menu_fuzz           libFuzzer (cmake -DMENU_FUZZ=ON, with clang : see CMakeLists.txt)
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "check.h"
+#include "../bench/menus.h"
+
+const int columns = 20, rows = 4;
+
+//rowsComeBack==================================================================
+//Every row of the LCD is a full line, and the current item can be reached.
+//-------------------------------------------------------------------------------
+static bool rowsComeBack(Menu &menu) {
+  char line[columns + 1];
+  int carets = 0;
+  for (int row = 0; row < rows; row++) {
+    menu.lcdLine(row, line);
+    if (strlen(line) != (size_t) columns) return false;
+    if (line[0] == '>') carets++;
+  }
+  if (carets != 1) return false;
+  return menu.getListIndex() >= 0 || menu.selectItem(menu.getCurrentItem());
+}
+
+//fuzzOne=======================================================================
+//Reads "data" (see above). Returns false if something was wrong.
+//-------------------------------------------------------------------------------
+static bool fuzzOne(const uint8_t *data, size_t size) {
+  size_t textSize = 0;
+  while (textSize < size && data[textSize] != 0) textSize++;
+  std::string text((const char *) data, textSize);
+  const uint8_t *ops = data + textSize + (textSize < size ? 1 : 0);
+  size_t opCount = size - (ops - data);
+  int failures = checkFailures;
+
+  Menu menu(text.c_str());
+  const MenuError &error = menu.error();
+  if (error.code != MenuTable::NONE) {
+    CHECK(error.offset >= 0 && error.offset <= (long) textSize);
+    CHECK(error.line >= 1 && error.item >= 1);
+  }
+#if __cplusplus >= 201402L
+  if (text.find_first_of("\r\n") == std::string::npos) CHECK(error.code == MenuTable::check(text.c_str()));
+#endif
+  if (error.code == MenuTable::NO_ITEMS || error.code == MenuTable::NO_DASH) return checkFailures == failures;
+
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(1, 2, 3, 4);
+  CHECK(rowsComeBack(menu));
+  char label[8] = "NEW";
+  for (size_t i = 0; i < opCount && checkFailures == failures; i++) {
+    int op = ops[i], item = op >> 3;                          //(An item number : 0 to 31.)
+    switch (op & 7) {
+      case 0: case 1: case 2: case 3:                         //A key : UP, DOWN, LEFT, RIGHT.
+        if (menu.update((op & 3) + 1) > 0) menu.done();
+        break;
+      case 4: menu.typeAhead("AEIN1234"[item & 7]); break;
+      case 5: label[3] = 'A' + (op & 15); menu.insertItem(item, op & 7, label, item % 2); break;
+      case 6: if (!menu.removeItem(item)) menu.renameItem(item, label); break;
+      case 7: menu.enableItem(item, (op & 8) != 0); break;
+    }
+    CHECK(rowsComeBack(menu));
+  }
+  return checkFailures == failures;
+}
+
+//libFuzzer calls this for each input.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  fuzzOne(data, size);
+  return 0;
+}
+
+#if !defined(MENU_LIBFUZZER)
+//mutate========================================================================
+//A few random changes to "text" : a char replaced, added or taken out, a piece copied.
+//-------------------------------------------------------------------------------
+static unsigned long seed = 12345;
+static unsigned long next(unsigned long range) { seed = seed * 1103515245UL + 12345UL; return (seed >> 16) % range; }
+
+static void mutate(std::string &text) {
+  static const char picks[] = "--::0123456789AZ\r\n";
+  for (int changes = 1 + next(6); changes > 0; changes--) {
+    size_t at = text.empty() ? 0 : next(text.length());
+    char c = next(4) == 0 ? (char) (1 + next(255)) : picks[next(sizeof(picks) - 1)];
+    switch (next(4)) {
+      case 0: if (at < text.length()) text[at] = c; break;
+      case 1: text.insert(at, 1, c); break;
+      case 2: if (at < text.length()) text.erase(at, 1 + next(4)); break;
+      case 3: if (at < text.length()) text.insert(next(text.length()), text.substr(at, 1 + next(16))); break;
+    }
+  }
+}
+
+static bool replay(const char *file) {
+  FILE *in = fopen(file, "rb");
+  if (!in) { printf("%s : can't be read\n", file); return false; }
+  std::string data;
+  char buffer[4096];
+  size_t got;
+  while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) data.append(buffer, got);
+  fclose(in);
+  return fuzzOne((const uint8_t *) data.data(), data.size());
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && atol(argv[1]) == 0) {                       //Files.
+    for (int i = 1; i < argc; i++) if (!replay(argv[i])) printf("%s : failed\n", argv[i]);
+    return checkResult("fuzz");
+  }
+  long runs = argc > 1 ? atol(argv[1]) : 20000;
+  const std::string seeds[] = {
+    "-READ:000--SENSORS:000---SENSOR A1:101---SENSOR A2:102--SWITCHES:000---SWITCH PIN 4:103"
+    "-SET:000--SERVO ARM:105--SERVO BASE:106-MOVE SERVOS:107",
+    "-A:000\r\n--A1:001\r\n--A2:002\n-B:000\n--B1:003\n",
+    makeMenu(40, 3),
+    makeMenu(12, 12, 0, "\n"),
+  };
+  for (long run = 0; run < runs; run++) {
+    std::string input = seeds[run % 4];
+    mutate(input);
+    input += '\0';
+    for (int ops = 1 + next(64); ops > 0; ops--) input += (char) (1 + next(255));
+    if (!fuzzOne((const uint8_t *) input.data(), input.size())) {
+      char file[32];                                          //To be replayed.
+      snprintf(file, sizeof(file), "fuzz-%ld.txt", run);
+      FILE *out = fopen(file, "wb");
+      if (out) { fwrite(input.data(), 1, input.size(), out); fclose(out); }
+      printf("run %ld failed : see %s\n", run, file);
+      break;
+    }
+  }
+  printf("fuzz : %ld runs\n", runs);
+  return checkResult("fuzz");
+}
+#endif
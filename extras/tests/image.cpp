@@ -0,0 +1,150 @@
+/*
+ * image : precompiled menus (MenuImage, made by extras/menuc).
+ * An image shows the same menu as the text it was made from. A truncated, damaged or made up image
+ * is refused (BAD_IMAGE) without a byte read past the size given : run it with -DMENU_SANITIZE=ON to see.
+ * A made up image with a good checksum is refused too if it's links could go round in circles.
+ */
+#include <Menu.h>
+#include <string.h>
+#include <vector>
+#include "check.h"
+
+const int columns = 20, rows = 4;
+const char *text = "-READ:000--SENSORS:000---SENSOR A1:101---SENSOR A2:102--SWITCHES:000---SWITCH PIN 4:103"
+                   "-SET:000--SERVO ARM:105--SERVO BASE:106-MOVE SERVOS:107-LONG ROUTINE:108";
+
+typedef std::vector<unsigned char> Bytes;
+
+static Bytes imageOf(const MenuTree &tree) {
+  Bytes image(tree.image(0, 0));
+  tree.image(image.data(), image.size());
+  return image;
+}
+
+static const MenuImage *header(const Bytes &image) { return (const MenuImage *) image.data(); }
+
+//The checksum of an image that was changed on purpose (Fletcher-16, as MenuTree::image()).
+static void resum(Bytes &image) {
+  unsigned sum1 = 0, sum2 = 0;
+  for (size_t i = sizeof(MenuImage); i < image.size(); i++) { sum1 = (sum1 + image[i]) % 255; sum2 = (sum2 + sum1) % 255; }
+  ((MenuImage *) image.data())->checksum = (sum2 << 8) | sum1;
+}
+
+static bool sameScreens(Menu &a, Menu &b) {      //The same keys, the same LCD.
+  char lineA[columns + 1], lineB[columns + 1];
+  unsigned long seed = 3;
+  for (int i = 0; i < 500; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    int key = 1 + (seed >> 16) % 4;
+    int actionA = a.update(key), actionB = b.update(key);
+    if (actionA != actionB) return false;
+    if (actionA > 0) { a.done(); b.done(); }
+    for (int row = 0; row < rows; row++) {
+      a.lcdLine(row, lineA);
+      b.lcdLine(row, lineB);
+      if (strcmp(lineA, lineB) != 0) return false;
+    }
+  }
+  return true;
+}
+
+static Menu *menuOf(const Bytes &image, bool inFlash = false) {
+  Menu *menu = new Menu(header(image), image.size(), inFlash);
+  menu->defineLcd(columns, rows);
+  menu->mapKeyInt(1, 2, 3, 4);
+  return menu;
+}
+
+static bool refused(const Bytes &image) {
+  MenuTree tree(header(image), image.size());
+  return tree.error().code == MenuTable::BAD_IMAGE && tree.items() == 1 && MenuTree::imageCheck(header(image), image.size()) == 0;
+}
+
+int main() {
+  MenuTree tree(text);
+  Bytes image = imageOf(tree);
+  CHECK(MenuTree::imageCheck(header(image), image.size()) == (long) image.size());
+
+  //The same menu, from RAM and (as on AVR) from flash.
+  for (int inFlash = 0; inFlash <= 1; inFlash++) {
+    Menu parsed(text);
+    parsed.defineLcd(columns, rows);
+    parsed.mapKeyInt(1, 2, 3, 4);
+    Menu *fromImage = menuOf(image, inFlash);
+    CHECK(fromImage->error().code == MenuTable::NONE);
+    CHECK(fromImage->itemNumber("SERVO BASE") == parsed.itemNumber("SERVO BASE"));
+    CHECK(sameScreens(parsed, *fromImage));
+    delete fromImage;
+  }
+
+  //Truncated : the size given is less than the header says.
+  Bytes shorter(image.begin(), image.end() - 1);
+  CHECK(refused(shorter));
+  Bytes headerOnly(image.begin(), image.begin() + sizeof(MenuImage) - 1);
+  CHECK(refused(headerOnly));
+
+  //Damaged : a byte of the menu changed.
+  Bytes damaged(image);
+  damaged[damaged.size() - 5] ^= 1;
+  CHECK(refused(damaged));
+
+  //A header that claims more nodes than there are bytes (nothing past the image may be read).
+  Bytes bigger(image);
+  ((MenuImage *) bigger.data())->nodes = 60000 > MENU_MAX_ITEMS ? MENU_MAX_ITEMS : 60000;
+  CHECK(refused(bigger));
+  Bytes longer(image);
+  ((MenuImage *) longer.data())->length = 0x7fff0000UL;
+  CHECK(refused(longer));
+  Bytes moreLabels(image);
+  ((MenuImage *) moreLabels.data())->labels = ((MenuImage *) moreLabels.data())->nodes;
+  ((MenuImage *) moreLabels.data())->nodes++;
+  resum(moreLabels);
+  CHECK(refused(moreLabels));
+
+  //Made up, with a good checksum : a label out of the menu, a link out of the nodes, a sorted label out of the nodes.
+  MenuNode *nodes = (MenuNode *) (image.data() + sizeof(MenuImage));
+  long last = header(image)->nodes;
+  Bytes outOfMenu(image);
+  ((MenuNode *) (outOfMenu.data() + sizeof(MenuImage)))[last].start = header(image)->length - 2;
+  resum(outOfMenu);
+  CHECK(refused(outOfMenu));
+  Bytes badLink(image);
+  ((MenuNode *) (badLink.data() + sizeof(MenuImage)))[2].next = last + 1;
+  resum(badLink);
+  CHECK(refused(badLink));
+  Bytes badSorted(image);
+  ((menuIndex *) (badSorted.data() + sizeof(MenuImage) + (last + 1) * sizeof(MenuNode)))[0] = 0;
+  resum(badSorted);
+  CHECK(refused(badSorted));
+  CHECK(nodes[last].length > 2);                 //(So that the label above does go past the menu.)
+
+  //Made up, with a good checksum, links within the nodes but in circles (selectItem() never returned).
+  Bytes cycle(image);
+  MenuNode *cycleNodes = (MenuNode *) (cycle.data() + sizeof(MenuImage));
+  cycleNodes[1].parent = 2;
+  cycleNodes[2].parent = 1;
+  resum(cycle);
+  CHECK(refused(cycle));
+  Bytes backward(image);
+  ((MenuNode *) (backward.data() + sizeof(MenuImage)))[2].next = 1;    //(SENSORS -> READ.)
+  resum(backward);
+  CHECK(refused(backward));
+  Bytes eldestBack(image);
+  ((MenuNode *) (eldestBack.data() + sizeof(MenuImage)))[2].eldest = 2;
+  resum(eldestBack);
+  CHECK(refused(eldestBack));
+  Bytes lostChild(image);
+  ((MenuNode *) (lostChild.data() + sizeof(MenuImage)))[0].children--;  //(The youngest item of the menu left out.)
+  resum(lostChild);
+  CHECK(refused(lostChild));
+
+  //Not aligned on 4 bytes (used where it is in RAM) : refused, but a copy in flash is read byte by byte.
+  Bytes shifted(image.size() + 1);
+  memcpy(shifted.data() + 1, image.data(), image.size());
+  const MenuImage *misaligned = (const MenuImage *) (shifted.data() + 1);
+  CHECK(MenuTree::imageCheck(misaligned, image.size()) == 0);
+  CHECK(MenuTree(misaligned, image.size()).error().code == MenuTable::BAD_IMAGE);
+  CHECK(MenuTree::imageCheck(misaligned, image.size(), true) == (long) image.size());
+
+  return checkResult("image");
+}
@@ -0,0 +1,161 @@
+/*
+ * keys : what the keys do.
+ *   bindings : several keys for one command, a key bound again or unbound, no more than MENU_KEYS keys
+ *   moves    : PAGE_UP, PAGE_DOWN, HOME, END and TOP
+ *   batch    : update(keys, count) scrolls 200 items and signals the LCD once; an action stops the batch
+ *   repeat   : a key held longer than keyRepeat() says jumps
+ */
+#include <Menu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "check.h"
+
+const int columns = 20, rows = 4;
+enum { UP = 1, DOWN, LEFT, RIGHT };
+
+//A flat menu : "ITEM 1" to "ITEM count", action 100 + n, then "LAST" with a submenu.
+static std::string flatMenu(int count) {
+  std::string text;
+  char item[32];
+  for (int n = 1; n <= count; n++) {
+    snprintf(item, sizeof(item), "-ITEM %d:%03d", n, 100 + n % 900);
+    text += item;
+  }
+  return text + "-LAST:000--INSIDE:001";
+}
+
+static int at(Menu &menu) {                       //The rank of the current item (ITEM n : n).
+  int length;
+  const char *label = menu.getCurrentLabel(length);
+  std::string text(label, length);
+  return text.compare(0, 5, "ITEM ") == 0 ? atoi(text.c_str() + 5) : 0;
+}
+
+static void bindings() {
+  std::string text = flatMenu(10);
+  Menu menu(text.c_str());
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);
+  CHECK(menu.mapKey(20, MENU_DOWN));              //Three keys for DOWN,
+  CHECK(menu.mapKey(20 + MENU_KEYS, MENU_DOWN));  //(the same entry of the table : the next one)
+  menu.update(DOWN);
+  menu.update(20);
+  menu.update(20 + MENU_KEYS);
+  CHECK(at(menu) == 4);
+  CHECK(menu.mapKey(20, MENU_NONE));              //one unbound : the other one is still found,
+  menu.update(20);
+  CHECK(at(menu) == 4);
+  menu.update(20 + MENU_KEYS);
+  CHECK(at(menu) == 5);
+  CHECK(menu.mapKey(20 + MENU_KEYS, MENU_UP));    //one bound again : it does the other thing.
+  menu.update(20 + MENU_KEYS);
+  CHECK(at(menu) == 4);
+  CHECK(menu.mapKey('w', MENU_DOWN));             //A char is not the int of the same value.
+  menu.update((int) 'w');
+  CHECK(at(menu) == 4);
+  menu.update('w');
+  CHECK(at(menu) == 5);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);          //mapKeyInt() replaces every int key of UP to RIGHT,
+  menu.update(20 + MENU_KEYS);
+  CHECK(at(menu) == 5);
+  menu.update('w');                               //not the chars.
+  CHECK(at(menu) == 6);
+
+  CHECK(!menu.mapKey(0, MENU_UP));                //0 is no key,
+  Menu full(text.c_str());
+  int bound = 0;
+  for (int key = 100; key < 100 + 2 * MENU_KEYS; key++) if (full.mapKey(key, MENU_DOWN)) bound++;
+  CHECK(bound == MENU_KEYS);                      //and there is room for MENU_KEYS keys.
+  CHECK(full.mapKey(100, MENU_NONE));
+  CHECK(full.mapKey(200, MENU_UP));               //(Room again.)
+}
+
+static void moves() {
+  std::string text = flatMenu(10);
+  Menu menu(text.c_str());
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);
+  menu.mapKey(5, MENU_PAGE_UP);
+  menu.mapKey(6, MENU_PAGE_DOWN);
+  menu.mapKey(7, MENU_HOME);
+  menu.mapKey(8, MENU_END);
+  menu.mapKey(9, MENU_TOP);
+  menu.update(6);                                 //A page : the rows of the LCD.
+  CHECK(at(menu) == 1 + rows);
+  menu.update(6);
+  menu.update(6);                                 //(Not past the youngest.)
+  CHECK(at(menu) == 0 && menu.getCurrentItem() == menu.itemNumber("LAST"));
+  menu.update(5);
+  CHECK(at(menu) == 11 - rows);
+  menu.update(7);
+  CHECK(at(menu) == 1);
+  menu.update(5);                                 //(Not before the eldest.)
+  CHECK(at(menu) == 1);
+  menu.update(8);
+  CHECK(menu.getCurrentItem() == menu.itemNumber("LAST"));
+  menu.update(RIGHT);
+  CHECK(menu.getCurrentItem() == menu.itemNumber("INSIDE"));
+  menu.update(9);                                 //Out of every submenu, to the first item.
+  CHECK(at(menu) == 1);
+}
+
+static void batch() {
+  std::string text = flatMenu(200);
+  Menu menu(text.c_str());
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);
+  menu.LcdUpdated();
+  MenuKey keys[199];
+  for (int i = 0; i < 199; i++) keys[i] = {DOWN, (unsigned long) i * 1000};
+  CHECK(menu.update(keys, 199) == 0);             //200 items scrolled,
+  CHECK(at(menu) == 200);
+  CHECK(menu.LcdNeedsUpdate());                   //one redraw.
+  menu.LcdUpdated();
+  MenuKey there[] = {{UP, 0}, {UP, 1000}, {DOWN, 2000}, {DOWN, 3000}};
+  menu.update(there, 4);                          //And back : none.
+  CHECK(at(menu) == 200);
+  CHECK(!menu.LcdNeedsUpdate());
+
+  MenuKey action[] = {{DOWN, 0}, {RIGHT, 1000}, {RIGHT, 2000}, {DOWN, 3000}};
+  menu.update(action, 1);
+  CHECK(menu.getCurrentItem() == menu.itemNumber("LAST"));
+  CHECK(menu.update(action + 1, 3) == 1);         //Into LAST, the action of INSIDE :
+  CHECK(menu.getCurrentItem() == menu.itemNumber("INSIDE"));  //DOWN is not read.
+  CHECK(menu.LcdNeedsUpdate());
+}
+
+static void repeat() {
+  std::string text = flatMenu(200);
+  Menu menu(text.c_str());
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);
+  menu.keyRepeat(500, 100, 5);                    //Held 500 ms (events less than 100 ms apart) : 5 at a time.
+  MenuKey held[21];
+  for (int i = 0; i < 21; i++) held[i] = {DOWN, (unsigned long) i * 50};
+  menu.update(held, 21);                          //0 to 450 ms : 1 each, 500 to 1000 ms : 5 each.
+  CHECK(at(menu) == 1 + 10 + 11 * 5);
+  MenuKey again[] = {{DOWN, 1200}, {DOWN, 1250}};
+  menu.update(again, 2);                          //Let go (200 ms) : one at a time again.
+  CHECK(at(menu) == 66 + 2);
+  MenuKey other[] = {{UP, 1300}, {DOWN, 1350}};
+  menu.update(other, 2);                          //An other key is not the same key held.
+  CHECK(at(menu) == 68);
+
+  menu.keyRepeat(500, 100, 0);                    //0 : a page (the rows of the LCD).
+  for (int i = 0; i < 11; i++) held[i] = {DOWN, 2000 + (unsigned long) i * 50};
+  menu.update(held, 11);                          //2000 to 2450 ms : 1 each, 2500 ms : a page.
+  CHECK(at(menu) == 68 + 10 + rows);
+  menu.keyRepeat(0, 100, 5);                      //Off.
+  for (int i = 0; i < 21; i++) held[i] = {DOWN, 3000 + (unsigned long) i * 50};
+  menu.update(held, 21);
+  CHECK(at(menu) == 82 + 21);
+}
+
+int main() {
+  bindings();
+  moves();
+  batch();
+  repeat();
+  return checkResult("keys");
+}
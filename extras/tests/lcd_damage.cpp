@@ -0,0 +1,130 @@
+/*
+ * lcd_damage : what lcdDamage() saves on the LCD.
+ * The same random keys drive two menus on two mock 20x4 LCDs :
+ *   full   : lcd.clear() and every row, each time LcdNeedsUpdate() (the sketch before lcdDamage())
+ *   damage : only the spans lcdDamage() reports (the sketch's showMenu())
+ * Both screens must always show what lcdLine() says, and the damage spans must send fewer bytes.
+ */
+#include <Menu.h>
+#include <string.h>
+#include "check.h"
+
+const int columns = 20, rows = 4;
+
+//MockLcd=========================================================================
+//An LCD that keeps what it shows and counts the bytes it receives
+//(a char : 1 byte, a command, setCursor() or clear() : 1 byte).
+//--------------------------------------------------------------------------------
+class MockLcd : public Print {
+  public:
+    char screen[rows][columns];
+    unsigned long bytes = 0;
+    MockLcd() { clear(); bytes = 0; }
+    void clear() { memset(screen, ' ', sizeof(screen)); row = col = 0; bytes++; }
+    void setCursor(int c, int r) { col = c; row = r; bytes++; }
+    size_t write(uint8_t c) override {
+      if (row < rows && col < columns) screen[row][col++] = c;
+      bytes++;
+      return 1;
+    }
+    bool shows(Menu &menu) {                      //Does the screen show what the menu says?
+      char line[columns + 1];
+      for (int r = 0; r < rows; r++) {
+        menu.lcdLine(r, line);
+        if (memcmp(screen[r], line, columns) != 0) return false;
+      }
+      return true;
+    }
+  private:
+    int row = 0, col = 0;
+};
+
+static void showFull(Menu &menu, MockLcd &lcd) {
+  char line[columns + 1];
+  if (!menu.LcdNeedsUpdate()) return;
+  lcd.clear();
+  for (int i = 0; i < rows; i++) {
+    lcd.setCursor(0, i);
+    menu.lcdLine(i, line);
+    lcd.print(line);
+  }
+  menu.LcdUpdated();
+}
+
+static void showDamage(Menu &menu, MockLcd &lcd) {
+  char line[columns + 1];
+  int first, last;
+  if (!menu.LcdNeedsUpdate()) return;
+  for (int i = 0; i < rows; i++) {
+    if (menu.lcdDamage(i, first, last)) {
+      menu.lcdLine(i, line);
+      line[last + 1] = '\0';
+      lcd.setCursor(first, i);
+      lcd.print(line + first);
+    }
+  }
+  menu.LcdUpdated();
+}
+
+int main() {
+  const char *text =
+    "-READ:000"
+    "--SENSORS:000"
+    "---SENSOR A1:101"
+    "---SENSOR A2:102"
+    "---SENSOR A3:103"
+    "---SENSOR A4:104"
+    "---SENSOR A5:105"
+    "--SWITCHES:000"
+    "---SWITCH PIN 4:106"
+    "---SWITCH PIN 5:107"
+    "-SET:000"
+    "--SERVO ARM:108"
+    "--SERVO BASE:109"
+    "--SERVO WRIST:110"
+    "--SERVO GRIP:111"
+    "--SERVO SPEED:112"
+    "--SERVO HOME:113"
+    "-MOVE SERVOS:114"
+    "-LONG ROUTINE:115"
+    "-SETTINGS:116"
+    "-ABOUT:117";
+  Menu full(text), damage(text);
+  MockLcd fullLcd, damageLcd;
+  full.defineLcd(columns, rows);
+  damage.defineLcd(columns, rows);
+  full.mapKeyInt(1, 2, 3, 4);
+  damage.mapKeyInt(1, 2, 3, 4);
+
+  unsigned long seed = 5;
+  for (int i = 0; i < 5000; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    int pick = (seed >> 16) % 100;
+    int key = pick < 30 ? 1 : (pick < 70 ? 2 : (pick < 85 ? 3 : 4));   //UP, DOWN, LEFT, RIGHT
+    if (full.update(key) > 0) full.done();
+    if (damage.update(key) > 0) damage.done();
+    showFull(full, fullLcd);
+    showDamage(damage, damageLcd);
+    CHECK(fullLcd.shows(full));
+    CHECK(damageLcd.shows(damage));
+    CHECK(memcmp(fullLcd.screen, damageLcd.screen, sizeof(fullLcd.screen)) == 0);
+    if (checkFailures) break;
+  }
+
+  printf("bytes sent : full %lu, damage %lu (%.0f%%)\n", fullLcd.bytes, damageLcd.bytes,
+         100.0 * damageLcd.bytes / fullLcd.bytes);
+  CHECK(damageLcd.bytes < fullLcd.bytes / 2);
+
+  //A caret move inside the window : column 0 of two rows, 2 chars and 2 setCursor().
+  Menu moved(text);
+  MockLcd movedLcd;
+  moved.defineLcd(columns, rows);
+  moved.mapKeyInt(1, 2, 3, 4);
+  showDamage(moved, movedLcd);
+  unsigned long before = movedLcd.bytes;
+  moved.update(2);
+  showDamage(moved, movedLcd);
+  CHECK(movedLcd.shows(moved));
+  CHECK(movedLcd.bytes - before == 4);
+  return checkResult("lcd_damage");
+}
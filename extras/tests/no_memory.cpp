@@ -0,0 +1,150 @@
+/*
+ * no_memory : a menu that runs out of memory says so (error() : NO_MEMORY) and keeps working.
+ * The allocations are made to fail on purpose (glibc : the real ones are __libc_...(), not with MENU_SANITIZE).
+ */
+#include <Menu.h>
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+#include "check.h"
+
+#if defined(__GLIBC__) && !defined(MENU_SANITIZE)
+enum { MALLOC, CALLOC, REALLOC, ANY };
+static int failing = -1;            //The kind of allocation that fails (-1 : none),
+static long failAfter = 0;          //after this many more of them succeed.
+
+static bool allocFails(int kind) {
+  if (kind != failing && failing != ANY) return false;
+  if (failAfter == 0) return true;
+  failAfter--;
+  return false;
+}
+
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *block, size_t size);
+  void *malloc(size_t size) { return allocFails(MALLOC) ? 0 : __libc_malloc(size); }
+  void *calloc(size_t count, size_t size) { return allocFails(CALLOC) ? 0 : __libc_calloc(count, size); }
+  void *realloc(void *block, size_t size) { return allocFails(REALLOC) ? 0 : __libc_realloc(block, size); }
+}
+
+const char *text = "-READ:000--SENSORS:000---SENSOR A1:101---SENSOR A2:102-SET:000--SERVO ARM:105-MOVE SERVOS:107";
+
+//labelIndex() : the nodes fit, the label index does not.
+static void labelIndex() {
+  failing = CALLOC; failAfter = 0;            //(The label index is the only calloc().)
+  Menu menu(text);
+  failing = -1;
+  CHECK(menu.error().code == MenuTable::NO_MEMORY);
+  CHECK(menu.itemNumber("SET") == 0);         //Nothing is found by label,
+  CHECK(menu.typeAhead('S') == 0);
+  char line[21];
+  menu.defineLcd(20, 4);
+  menu.lcdLine(1, line);                      //but the menu works.
+  CHECK(strncmp(line, " SET", 4) == 0);
+  menu.mapKeyInt(1, 2, 3, 4);
+  menu.update(4);
+  CHECK(menu.getCurrentItem() == 2);
+}
+
+//defineLcd() : the rows do not fit. The LCD stays as it was.
+static void lcdRows() {
+  MenuTree tree(text);
+  failing = ANY; failAfter = 0;               //(The rows are all a Menu sharing a tree allocates : realloc(0, ...) may be a malloc().)
+  Menu menu(tree);
+  failing = -1;
+  CHECK(menu.error().code == MenuTable::NO_MEMORY);
+  menu.LcdUpdated();                          //No row yet : none is drawn.
+  CHECK(menu.lcdDamage() == 0);
+  CHECK(menu.defineLcd(20, 4));
+  char line[21];
+  menu.lcdLine(0, line);
+  CHECK(strcmp(line, ">READ               ") == 0);
+  failing = REALLOC; failAfter = 0;
+  CHECK(!menu.defineLcd(10, 8));
+  failing = -1;
+  menu.lcdLine(0, line);                      //Still 4 rows of 20 columns.
+  CHECK(strcmp(line, ">READ               ") == 0);
+  menu.updateLcd();
+  CHECK(menu.lcdDamage() == 0xF);
+}
+
+//listRefresh() : the copies of the labels of a list do not fit. The entries are shown without them.
+class Entries : public MenuSource {
+  public:
+    long count() override { return 10; }
+    int label(long index, char *buffer, int size) override { return snprintf(buffer, size, "ENTRY %ld", index); }
+    int action(long) override { return 0; }
+};
+
+static void listCopies() {
+  for (int fails = 0; fails < 2; fails++) {   //(The copies, then their labels.)
+    Menu menu(text);
+    Entries entries;
+    menu.defineLcd(20, 4);
+    menu.mapKeyInt(1, 2, 3, 4);
+    CHECK(menu.attachSource(menu.itemNumber("SET"), &entries));
+    CHECK(menu.selectItem(menu.itemNumber("SET")));
+    failing = ANY; failAfter = fails;
+    menu.update(4);
+    failing = -1;
+    CHECK(menu.error().code == MenuTable::NO_MEMORY);
+    CHECK(menu.getListIndex() == 0);
+    char line[21];
+    menu.lcdLine(0, line);
+    CHECK(strcmp(line, ">                   ") == 0);
+    menu.update(2);
+    CHECK(menu.getListIndex() == 1);
+    int length = -1;
+    menu.getCurrentLabel(length);
+    CHECK(length == 0);
+  }
+}
+
+//MenuTree(image, size, inFlash) : the nodes, then the sorted labels, do not fit in RAM.
+static void imageInFlash() {
+  MenuTree parsed(text);
+  std::vector<unsigned char> image(parsed.image(0, 0));
+  parsed.image(image.data(), image.size());
+  for (int fails = 0; fails < 2; fails++) {
+    failing = MALLOC; failAfter = fails;
+    MenuTree tree((const MenuImage *) image.data(), image.size(), true);
+    failing = -1;
+    CHECK(tree.error().code == MenuTable::NO_MEMORY);
+    CHECK(tree.items() == 1);
+  }
+  MenuTree tree((const MenuImage *) image.data(), image.size(), true);
+  CHECK(tree.error().code == MenuTable::NONE);
+  CHECK(tree.items() == parsed.items());
+}
+
+#if defined(ARDUINO)
+//MenuTree(String) : the copy of the menu does not fit.
+static void stringCopy() {
+  String items(text);
+  failing = MALLOC; failAfter = 0;            //(Strings use realloc() : the copy is the first malloc().)
+  MenuTree tree(items);
+  failing = -1;
+  CHECK(tree.error().code == MenuTable::NO_MEMORY);
+  Menu menu(tree);
+  char line[21];
+  menu.defineLcd(20, 4);
+  menu.lcdLine(0, line);                      //The menu says so.
+  CHECK(strncmp(line, ">NO MEMORY", 10) == 0);
+}
+#endif
+#endif
+
+int main() {
+#if defined(__GLIBC__) && !defined(MENU_SANITIZE)
+  labelIndex();
+  lcdRows();
+  listCopies();
+  imageInFlash();
+#if defined(ARDUINO)
+  stringCopy();
+#endif
+#endif
+  return checkResult("no_memory");
+}
@@ -0,0 +1,113 @@
+/*
+ * parse_errors : what error() says about a malformed menu, and the items kept before it.
+ */
+#include <Menu.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "check.h"
+
+//Labels of 255 and 256 chars, for the parser and for MENU_TABLE.
+#define CHARS16 "ABCDEFGHIJKLMNOP"
+#define CHARS256 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 \
+                 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16
+#define CHARS255 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 \
+                 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 CHARS16 "ABCDEFGHIJKLMNO"
+
+static void error(const char *text, int code, long item, long line, long offset) {
+  Menu menu(text);
+  const MenuError &error = menu.error();
+  CHECK(error.code == code);
+  CHECK(error.item == item);
+  CHECK(error.line == line);
+  CHECK(error.offset == offset);
+  if (error.code != code) printf("  \"%.40s\" : code %d\n", text, error.code);
+}
+
+//Labels : up to 255 chars, a longer one is an error (not cut, so that itemNumber() still finds it).
+static void longLabels() {
+  std::string longest = "-A:001-" CHARS255 ":002";
+  Menu menu(longest.c_str());
+  CHECK(menu.error().code == MenuTable::NONE);
+  CHECK(menu.itemNumber(CHARS255) == 2);
+  int length = 0;
+  menu.mapKeyInt(1, 2, 3, 4);
+  menu.update(2);
+  menu.getCurrentLabel(length);
+  CHECK(length == 255);
+
+  std::string tooLong = "-A:001\n-" CHARS256 ":002\n-B:003";
+  error(tooLong.c_str(), MenuTable::LONG_LABEL, 2, 2, 8 + 255);
+  Menu kept(tooLong.c_str());
+  CHECK(kept.itemNumber("A") == 1);                     //The item before is kept,
+  CHECK(kept.itemNumber("B") == 0);                     //not the ones after.
+
+#if __cplusplus >= 201402L
+  static_assert(MenuTable::check("-A:001-" CHARS255 ":002") == MenuTable::NONE, "255 chars");
+  static_assert(MenuTable::check("-A:001-" CHARS256 ":002") == MenuTable::LONG_LABEL, "256 chars");
+  MENU_TABLE(table, "-A:001-" CHARS255 ":002");
+  Menu fromTable(table);
+  CHECK(fromTable.itemNumber(CHARS255) == 2);
+#endif
+}
+
+//A menu longer than the offsets of the labels can go : refused, not wrapped round (built with -DMENU_INDEX_BITS=8 :
+//65535 chars, 255 items of 255 chars are more).
+static void longMenu() {
+  if (MENU_MAX_LENGTH > 1000000L) return;
+  std::string text;
+  for (int item = 1; item <= MENU_MAX_ITEMS && (long) text.length() <= MENU_MAX_LENGTH; item++) text += "-" CHARS255 ":001";
+  CHECK((long) text.length() > MENU_MAX_LENGTH);
+  Menu menu(text.c_str());
+  CHECK(menu.error().code == MenuTable::LONG_MENU);
+  CHECK(menu.error().offset == MENU_MAX_LENGTH);
+  Menu fits(text.c_str(), MENU_MAX_LENGTH - 4);                 //(The last item cut : the items before it are kept.)
+  CHECK(fits.error().code != MenuTable::LONG_MENU && fits.itemNumber(CHARS255) == 1);
+}
+
+//A MENU_TABLE : it's labels sorted by the compiler, in the order the parser sorts them.
+static void tableLabels() {
+#if __cplusplus >= 201402L
+#define SAME_LABELS "-b:001-B:002-a:003--ab:004--A:005-c:006-AB:007"
+  MENU_TABLE(table, SAME_LABELS);
+  static_assert(table.sorted[0] == 3 && table.sorted[1] == 5 && table.sorted[2] == 4 && table.sorted[3] == 7, "a A ab AB");
+  static_assert(table.sorted[4] == 1 && table.sorted[5] == 2 && table.sorted[6] == 6, "b B c");
+  Menu fromTable(table), parsed(SAME_LABELS);
+  const char *labels[] = {"a", "A", "ab", "AB", "b", "B", "c", "C", "abc", ""};
+  for (const char *label : labels) CHECK(fromTable.itemNumber(label) == parsed.itemNumber(label));
+#endif
+}
+
+//A length given : nothing past it is read (run it with -DMENU_SANITIZE=ON to see), there may be no '\0'.
+static void lengths() {
+  const char text[] = "-A:001\n-B:002\n-C:003";
+  std::vector<char> exact(text, text + sizeof(text) - 1);      //(As a file mmap()'ed : the page ends there.)
+  Menu menu(exact.data(), (long) exact.size());
+  CHECK(menu.error().code == MenuTable::NONE);
+  CHECK(menu.itemNumber("C") == 3);
+  Menu cut(text, 14);                                          //Up to "B" : "C" is not read.
+  CHECK(cut.error().code == MenuTable::NONE);
+  CHECK(cut.itemNumber("B") == 2 && cut.itemNumber("C") == 0);
+  Menu inLabel(text, 16);                                      //Cut before the colon of "C" : an error, after "B".
+  CHECK(inLabel.error().code == MenuTable::MISSING_COLON && inLabel.error().item == 3);
+  CHECK(inLabel.itemNumber("B") == 2);
+  Menu empty(text, 0);
+  CHECK(empty.error().code == MenuTable::NO_ITEMS);
+}
+
+int main() {
+  error("", MenuTable::NO_ITEMS, 1, 1, 0);
+  error("\r\n\r\n", MenuTable::NO_ITEMS, 1, 3, 4);
+  error("READ:000", MenuTable::NO_DASH, 1, 1, 0);
+  error("-READ:000-SET", MenuTable::MISSING_COLON, 2, 1, 9);
+  error("-READ:000\n-SET\n:001", MenuTable::MISSING_COLON, 2, 2, 10);
+  error("-READ:00x", MenuTable::BAD_ACTION, 1, 1, 8);
+  error("-READ:000;", MenuTable::BAD_ACTION, 1, 1, 9);
+  error("-READ:000---SET:001", MenuTable::LEVEL_JUMP, 2, 1, 9);
+  error("-READ:000\r\n--SET:001", MenuTable::NONE, 0, 0, 0);
+  longLabels();
+  lengths();
+  tableLabels();
+  longMenu();
+  return checkResult("parse_errors");
+}
@@ -0,0 +1,107 @@
+/*
+ * source_list : a MenuSource of a million entries.
+ * The Menu must ask only for the labels it shows : scrolling the whole list one entry at a time
+ * costs about one label() call per key, and jumping to the end a screenful.
+ * An LCD without a row (or a column) is refused : the copies of the labels stay as they were.
+ */
+#include <Menu.h>
+#include <string.h>
+#include "check.h"
+
+const int columns = 20, rows = 4;
+const long entries = 1000000;
+
+//Files=============================================================
+//A million files, "FILE 0000000" to "FILE 0999999" : only counts the calls.
+//------------------------------------------------------------------
+class Files : public MenuSource {
+  public:
+    unsigned long labelCalls = 0;
+    long count() override { return entries; }
+    int label(long index, char *buffer, int size) override {
+      labelCalls++;
+      char text[16];
+      int length = snprintf(text, sizeof(text), "FILE %07ld", index);
+      if (length > size) length = size;
+      memcpy(buffer, text, length);
+      return length;
+    }
+    int action(long index) override { return index == entries - 1 ? 999 : 0; }
+};
+
+static void frame(Menu &menu) {                   //Draw the LCD (only the rows that changed).
+  char line[columns + 1];
+  int first, last;
+  if (!menu.LcdNeedsUpdate()) return;
+  for (int row = 0; row < rows; row++) if (menu.lcdDamage(row, first, last)) menu.lcdLine(row, line);
+  menu.LcdUpdated();
+}
+
+static bool shows(Menu &menu, int row, const char *text) {
+  char line[columns + 1];
+  menu.lcdLine(row, line);
+  return strncmp(line, text, strlen(text)) == 0;
+}
+
+int main() {
+  Menu menu("-FILES:000-ABOUT:001");
+  Files files;
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(1, 2, 3, 4);                     //UP, DOWN, LEFT, RIGHT
+  menu.mapKey(5, MENU_END);
+  menu.mapKey(6, MENU_HOME);
+  CHECK(menu.attachSource(menu.itemNumber("FILES"), &files));
+
+  menu.update(4);                                 //Into the list.
+  frame(menu);
+  CHECK(menu.getListIndex() == 0);
+  CHECK(shows(menu, 0, ">FILE 0000000"));
+  CHECK(shows(menu, 3, " FILE 0000003"));
+  CHECK(files.labelCalls <= (unsigned long) rows);
+
+  unsigned long before = files.labelCalls;        //The whole list, one entry at a time.
+  for (long i = 1; i < entries; i++) {
+    menu.update(2);
+    frame(menu);
+  }
+  unsigned long calls = files.labelCalls - before;
+  printf("scrolling %ld entries : %lu label() calls\n", entries - 1, calls);
+  CHECK(menu.getListIndex() == entries - 1);
+  CHECK(shows(menu, 3, ">FILE 0999999"));
+  CHECK(shows(menu, 0, " FILE 0999996"));
+  CHECK(calls <= (unsigned long) entries);        //One new row per key.
+
+  before = files.labelCalls;                      //Home and end again : a screenful each.
+  menu.update(6);
+  frame(menu);
+  CHECK(shows(menu, 0, ">FILE 0000000"));
+  menu.update(5);
+  frame(menu);
+  CHECK(shows(menu, 3, ">FILE 0999999"));
+  CHECK(files.labelCalls - before <= 2UL * rows);
+
+  before = files.labelCalls;                      //Nothing moves : nothing is asked for.
+  for (int i = 0; i < 1000; i++) {
+    menu.update(2);
+    frame(menu);
+    char line[columns + 1];
+    for (int row = 0; row < rows; row++) menu.lcdLine(row, line);
+  }
+  CHECK(files.labelCalls == before);
+
+  CHECK(menu.update(4) == 999);                   //The action of the last entry,
+  menu.done();
+  menu.update(3);                                 //and out of the list.
+  CHECK(menu.getListIndex() == -1);
+  CHECK(menu.getCurrentItem() == menu.itemNumber("FILES"));
+
+  menu.update(4);                                 //(listEntry() used to divide by the rows.)
+  CHECK(!menu.defineLcd(columns, 0));
+  CHECK(!menu.defineLcd(0, rows));
+  frame(menu);
+  CHECK(shows(menu, 0, ">FILE 0000000"));
+  menu.update(2);
+  frame(menu);
+  CHECK(shows(menu, 1, ">FILE 0000001"));
+  return checkResult("source_list");
+}
@@ -0,0 +1,64 @@
+/*
+ * stats : what MENU_STATS counts (built with MENU_STATS, see CMakeLists.txt).
+ *   parse   : the time spent parsing is taken, and kept by resetStats()
+ *   update  : each update() is timed, a batch of keys once
+ *   redraws : LcdUpdated() counts a redraw only when LcdNeedsUpdate()
+ *   strings : lcdLine() builds two String temporaries
+ *   export  : exportStats() hands the counts to the hook, then starts counting again
+ */
+#if !defined(MENU_STATS)
+#error "stats is built with MENU_STATS"
+#endif
+#include <Menu.h>
+#include <string>
+#include "check.h"
+#include "../bench/menus.h"
+
+const int columns = 20, rows = 4;
+enum { UP = 1, DOWN, LEFT, RIGHT };
+
+static MenuStats exported;
+static int exports = 0;
+static void hook(const MenuStats &stats) { exported = stats; exports++; }
+
+int main() {
+  long items = MENU_MAX_ITEMS < 2000 ? MENU_MAX_ITEMS : 2000;   //Big enough to take a few µs.
+  std::string text = makeMenu(items, items, 100);               //(Flat : DOWN always moves.)
+  Menu menu(text.c_str());
+  CHECK(menu.error().code == MenuTable::NONE);
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(UP, DOWN, LEFT, RIGHT);
+  const MenuStats &stats = menu.stats();
+  unsigned long parseTime = stats.parseTime;
+  CHECK(parseTime > 0);                                         //parse
+  CHECK(stats.update.count == 0 && stats.redraws == 0 && stats.strings == 0);
+  CHECK(menu.stats().nodeBytes > 0 && stats.indexBytes > 0);
+
+  menu.update(DOWN);                                            //update
+  menu.update(UP);
+  MenuKey keys[] = {{DOWN, 0}, {DOWN, 1000}, {DOWN, 2000}};
+  menu.update(keys, 3);
+  menu.stats();
+  CHECK(stats.update.count == 3);
+  CHECK(stats.update.min <= stats.update.max && stats.update.max <= stats.update.total);
+
+  CHECK(menu.LcdNeedsUpdate());                                 //redraws
+  menu.LcdUpdated();
+  menu.LcdUpdated();                                            //(Nothing changed : not a redraw.)
+  CHECK(menu.stats().redraws == 1);
+  menu.update(DOWN);
+  menu.LcdUpdated();
+  CHECK(menu.stats().redraws == 2);
+
+  for (int row = 0; row < rows; row++) menu.lcdLine(row);       //strings
+  CHECK(menu.stats().strings == 2 * rows);
+
+  menu.statsHook(hook);                                         //export
+  menu.exportStats();
+  CHECK(exports == 1);
+  CHECK(exported.update.count == 4 && exported.redraws == 2 && exported.strings == 2 * rows);
+  menu.stats();
+  CHECK(stats.update.count == 0 && stats.redraws == 0 && stats.strings == 0);
+  CHECK(stats.parseTime == parseTime);
+  return checkResult("stats");
+}
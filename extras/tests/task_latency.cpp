@@ -0,0 +1,105 @@
+/*
+ * task_latency : the menu stays responsive while MenuTasks run.
+ * A loop() like the sketch's : a key now and then, update(), poll() and a redraw.
+ * MENU_TASKS tasks run all along, each one doing a long job a little at a time.
+ * update() must stay short whatever the tasks do, and a key must show on the LCD within one loop :
+ * a step of each task, not a whole job (as an action that blocks until it is done would).
+ * The 99th percentiles are checked (a host computer may be busy with something else now and then).
+ */
+#include <Menu.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "check.h"
+
+const int columns = 20, rows = 4;
+
+//Job===============================================================
+//A long job (a checksum), "chunk" numbers per step.
+//------------------------------------------------------------------
+class Job : public MenuTask {
+  public:
+    Job(long total = 20000000L, long chunk = 20000L) : total(total), chunk(chunk) {}
+    unsigned long sum = 0;
+    long done = 0;
+    bool cancelled = false;
+    bool step() override {
+      for (long end = done + chunk; done < end && done < total; done++) sum = sum * 31 + (unsigned long) done;
+      return done < total;
+    }
+    void cancel() override { cancelled = true; }
+    void reset() { done = 0; sum = 0; cancelled = false; }
+    const long total, chunk;
+};
+
+static void frame(Menu &menu) {
+  char line[columns + 1];
+  int first, last;
+  if (!menu.LcdNeedsUpdate()) return;
+  for (int row = 0; row < rows; row++) if (menu.lcdDamage(row, first, last)) menu.lcdLine(row, line);
+  menu.LcdUpdated();
+}
+
+int main() {
+  Menu menu("-READ:000--SENSOR A1:101--SENSOR A2:102-SET:000--SERVO ARM:105--SERVO BASE:106-MOVE:107-LONG:108");
+  menu.defineLcd(columns, rows);
+  menu.mapKeyInt(1, 2, 3, 4);
+  menu.mapKeyCancel(9);
+
+  Job jobs[MENU_TASKS];
+  for (int i = 0; i < MENU_TASKS; i++) CHECK(menu.start(&jobs[i]));
+  Job extra(10, 10);
+  CHECK(!menu.start(&extra));                   //No room left.
+
+  //The whole job, as a blocking action would run it.
+  Job blocking(20000000L, 20000000L);
+  unsigned long started = micros();
+  blocking.step();
+  unsigned long blockingTime = micros() - started;
+
+  //loop() : poll(), a key one loop out of 4, and the LCD.
+  std::vector<unsigned long> updates, loops;
+  unsigned long seed = 7;
+  bool running = true;
+  while (running) {
+    unsigned long loopStarted = micros();
+    running = menu.poll() > 0;
+    seed = seed * 1103515245UL + 12345UL;
+    if ((seed >> 16) % 4 == 0) {
+      int key = 1 + (seed >> 20) % 4;
+      unsigned long updateStarted = micros();
+      if (menu.update(key) > 0) menu.done();
+      updates.push_back(micros() - updateStarted);
+    }
+    frame(menu);
+    loops.push_back(micros() - loopStarted);
+  }
+  for (int i = 0; i < MENU_TASKS; i++) {
+    CHECK(jobs[i].done == jobs[i].total);
+    CHECK(jobs[i].sum == blocking.sum);
+    CHECK(!jobs[i].cancelled);
+  }
+  std::sort(updates.begin(), updates.end());
+  std::sort(loops.begin(), loops.end());
+  unsigned long update99 = updates[updates.size() * 99 / 100], loop99 = loops[loops.size() * 99 / 100];
+  printf("%zu loops, %zu keys : update() %lu us, loop %lu us (median %lu us), one job %lu us\n",
+         loops.size(), updates.size(), update99, loop99, loops[loops.size() / 2], blockingTime);
+  CHECK(update99 < 1000);                       //update() never runs a task,
+  CHECK(loop99 < blockingTime / 4);             //and a key shows after a step of each task, not a job.
+
+  //The cancel key stops the last task started, the others go on.
+  for (int i = 0; i < MENU_TASKS; i++) {
+    jobs[i].reset();
+    CHECK(menu.start(&jobs[i]));
+  }
+  menu.poll();
+  CHECK(menu.update(9) == 0);
+  CHECK(jobs[MENU_TASKS - 1].cancelled);
+  CHECK(!menu.running(&jobs[MENU_TASKS - 1]));
+  for (int i = 0; i < MENU_TASKS - 1; i++) CHECK(menu.running(&jobs[i]));
+  CHECK(menu.poll() == MENU_TASKS - 1);
+  for (int i = 0; i < MENU_TASKS - 1; i++) CHECK(menu.cancel(&jobs[i]));
+  CHECK(menu.poll() == 0);
+
+  return checkResult("task_latency");
+}